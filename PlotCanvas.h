@@ -0,0 +1,56 @@
+/* File: PlotCanvas.h
+ *
+ * Class PlotCanvas
+ * The drawing surface of a Plotstream: everything Plotstream draws
+ * (axes, grid, labels, traces) goes through these few functions.
+ *
+ * Implementations:
+ *	PlotGdi		a Windows device context (PlotGdi.h, Windows only)
+ *	PlotRaster	an RGBA image in memory, on any system (PlotRaster.h)
+ *	PlotSvg, PlotPdf	SVG and PDF files (PlotVector.h)
+ *
+ * Coordinates are pixels, origin at top left, y downwards.
+ * Lines follow GDI: lineto() does not draw its end pixel.
+ *
+ * Canvases that can keep pixels off-screen give layers: canvases of
+ * the same kind and size that are drawn once, kept, and copied onto
+ * the canvas as a whole (Plotstream caches its axes so). Vector files
+ * have none and are drawn on directly.
+ */
+#pragma once
+
+#include "PlotData.h"
+
+class PlotCanvas{
+public:
+ enum PenStyle{SOLID,DOT};
+ enum TextAlign{LEFT,CENTER,RIGHT};	// horizontally; text hangs below y
+
+ virtual ~PlotCanvas() {}
+	/* Size of the drawing area in pixels */
+ virtual int width() const=0;
+ virtual int height() const=0;
+	/* Fill the whole drawing area */
+ virtual void erase(Color colour=WHITE)=0;
+	/* Select the pen used by lineto() and rectangle() */
+ virtual void pen(Color colour, int width=1, PenStyle style=SOLID)=0;
+ virtual void moveto(int x, int y)=0;
+	/* Draw a line from the current position, which becomes (x,y) */
+ virtual void lineto(int x, int y)=0;
+	/* Outline from (l,t) to (r-1,b-1) with the pen, inside filled with "fill" */
+ virtual void rectangle(int l, int t, int r, int b, Color fill=WHITE)=0;
+	/* Draw s with its top edge at y */
+ virtual void text(int x, int y, const char*s, TextAlign align=LEFT, Color colour=BLACK)=0;
+	/* Width and height of s in pixels */
+ virtual void textSize(const char*s, int&cx, int&cy)=0;
+	/* Draw lines only within (l,t) to (r-1,b-1), until unclip() */
+ virtual void clip(int l, int t, int r, int b)=0;
+ virtual void unclip()=0;
+	/* A new off-screen layer of the same size, filled with the
+	   background, to be deleted by the caller; 0 if this kind of
+	   canvas has none */
+ virtual PlotCanvas*layer() const {return 0;}
+	/* Replace the drawing with that of a layer made by layer();
+	   false if it was not, or does not have the same size */
+ virtual bool copy(const PlotCanvas&) {return false;}
+};
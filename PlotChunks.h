@@ -0,0 +1,92 @@
+/* File: PlotChunks.h
+ *
+ * Class Plotchunks
+ * Data for one axis larger than memory: the elements of a binary file of
+ * Plotdata (PlotFile.h), read in chunks of a fixed number of elements as
+ * they are used. The chunks read are kept up to a budget of memory;
+ * beyond it, the one used least recently is dropped (LRU). Counts and
+ * offsets in the file are 64-bit.
+ *
+ * Plotchunks are used in expressions (PlotExpr.h) and plotted through a
+ * Plotview, both a block at a time; save() writes an expression to a
+ * file the same way, so a result as large as its operands does not need
+ * memory either.
+ *
+ * Example (a 50 GB capture, 256 MB of it in memory at a time):
+ *		Plotchunks t, v;
+ *		t.open("time.kpd");
+ *		v.open("volts.kpd");
+ *		Plotchunks::save("watts.kpd", v*v/50);
+ *		Plotchunks w;
+ *		w.open("watts.kpd");
+ *		ps.addplot(Plotview(t), Plotview(w));
+ *
+ * Reading is thread-safe. A Plotchunks must outlive the views of it.
+ *
+ * This file is included by PlotData.h and is not meant to be used alone.
+ */
+#pragma once
+
+class Plotchunks:public PlotExpr<Plotchunks>{
+public:
+	/* Keep up to "budget" bytes of chunks of "chunk" elements */
+ explicit Plotchunks(size_t budget=size_t(256)<<20, size_t chunk=size_t(1)<<20);
+ ~Plotchunks();
+	/* Read the elements of a file of Plotdata::save() or save() from now
+	   on; false if it cannot be, or has more than a size_t can count */
+ bool open(const char*path);
+ void close();
+ size_t size() const {return n;}
+	/* Range of the finite elements, and number of the others, as saved
+	   in the file; false if it has none */
+ bool range(Plotdata::Range&r, uint64_t&nonfinite) const;
+ float_t operator[](size_t i) const;
+	// Elements i0..i0+m-1, copied into buf (PlotExpr.h)
+ const float_t*block(size_t i0, size_t m, float_t*buf) const;
+	/* Bytes of chunks in memory now, and chunks read from the file so far */
+ size_t resident() const;
+ uint64_t reads() const;
+
+	/* Write the elements of e to a file, a block at a time, with their
+	   range; false on failure */
+ template<class E> static bool save(const char*path, const PlotExpr<E>&e) {
+  Writer w(path);
+  const E&x=e.self();
+  size_t n=x.size();
+  float_t buf[PLOT_BLOCK];
+  for (size_t i=0; i<n; i+=PLOT_BLOCK) {
+   size_t m=n-i<PLOT_BLOCK ? n-i : PLOT_BLOCK;
+   w.write(x.block(i,m,buf),m);
+  }
+  return w.finish();
+ }
+private:
+ struct Store;				// file, chunks in memory, LRU order
+ unique_ptr<Store> s;
+ size_t n;
+ class Writer{
+ public:
+  explicit Writer(const char*path);
+  ~Writer();
+  void write(const float_t*p, size_t m);
+  bool finish();
+ private:
+  void*f;				// FILE*
+  vector<float_t> buf;
+  Plotdata::Range r;
+  uint64_t count,bad;
+  void flush();
+ };
+ Plotchunks(const Plotchunks&);
+ void operator=(const Plotchunks&);
+};
+
+inline Plotview::Plotview(const Plotchunks&c):p(&c),n(c.size()),step(0),kind(CHUNKS),
+ gain(1),offset(0),native(false) {}
+inline float_t Plotview::chunkAt(size_t i) const {return ((const Plotchunks*)p)->operator[](i);}
+inline const float_t*Plotview::chunkBlock(size_t i0, size_t m, float_t*buf) const {
+ return ((const Plotchunks*)p)->block(i0,m,buf);
+}
+
+// Plotchunks are referenced in expressions, as Plotdata
+template<> struct PlotExprRef<Plotchunks>{typedef const Plotchunks&type;};
@@ -23,10 +23,24 @@
 #include <vector>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "PlotPool.h"
 
 // BEGIN Windows-specific, MSVC2008 specific
+#ifdef _WIN32
 #include <windows.h>
 typedef COLORREF Color;	// central switch between GDI and GDIplus
+#else	// same layout as COLORREF, for drawing without Windows (PlotRaster.h)
+#include <stdint.h>
+typedef uint32_t Color;
+#define RGB(r,g,b) ((Color)((uint8_t)(r)|(uint8_t)(g)<<8|(uint32_t)(uint8_t)(b)<<16))
+#define GetRValue(c) ((uint8_t)(c))
+#define GetGValue(c) ((uint8_t)((c)>>8))
+#define GetBValue(c) ((uint8_t)((c)>>16))
+#endif
 #define COLOR(r,g,b) RGB(r,g,b)
 
 const Color BLACK	=RGB( 0, 0, 0 );
@@ -85,12 +99,27 @@ typedef float_t (*BinFunc)(float_t operand1, float_t operand2);
 /** When true defines a range to be logarithmic */
 typedef bool LogSpace;
 
+/** Storage of the elements of a Plotdata: a plain vector, or a vector in
+ *  pooled memory (PlotPool.h) when the library and the programs using it
+ *  are all built with PLOT_POOL defined */
+#ifdef PLOT_POOL
+typedef vector<float_t,PlotAlloc<float_t> > PlotBuffer;
+#else
+typedef vector<float_t> PlotBuffer;
+#endif
+
 /** Define data iterator */
-typedef vector<float_t>::const_iterator  dataIterator;
+typedef PlotBuffer::const_iterator  dataIterator;
 
 /** Remove case sensitivity for Plotdata class */
 class Plotdata;
 
+/** A file mapped into memory (PlotFile.h) */
+class PlotMap;
+
+/** Elements of someone else's data, maybe strided (PlotView.h) */
+class Plotview;
+
 /** #define Plotdata & as a type (avoid using confusing '&' symbols in C) */
 
 /** Number of points in a plot */
@@ -108,7 +137,11 @@ const float_t NOPLOT = numeric_limits<float_t>::quiet_NaN(); // Any point of thi
 //const int NOCOLOR      = -1;
 //const int RESETCOLOR   = -2;
 
-class Plotdata{
+// Lazy arithmetic (+ - * / ^ and unary -) on Plotdata
+#include "PlotExpr.h"
+#include "PlotThreads.h"
+
+class Plotdata:public PlotExpr<Plotdata>{
     // --------------------------------------------------------------
     //     OPERATORS
 
@@ -117,40 +150,98 @@ class Plotdata{
 
 public:
 
- Plotdata operator +  (const Plotdata &) const;
- Plotdata operator +  (float_t) const;
- Plotdata operator -  (const Plotdata &) const;
- Plotdata operator -  (float_t) const;
- Plotdata operator *  (const Plotdata &) const;
- Plotdata operator *  (float_t) const;
- Plotdata operator /  (const Plotdata &) const;
- Plotdata operator /  (float_t) const;
- Plotdata operator ^  (float_t) const;
- Plotdata operator -  ( ) const;
+    // Arithmetic operators are in PlotExpr.h; they build an expression
+    // which is evaluated in one pass on assignment to a Plotdata.
+ template<class E> Plotdata & operator = (const PlotExpr<E>&e) {assign(e.self()); return *this;}
+ Plotdata & operator = (const Plotdata &) = default;
+ Plotdata & operator = (Plotdata &&); // takes the elements, leaving the other empty
  Plotdata & operator << (const Plotdata &); // concatenate
+ Plotdata & operator << (Plotdata &&); // the same, taking the elements if empty
  Plotdata & operator << (float_t); // add a double to the data
 
     // --------------------------------------------------------------
     // Constructors
- inline Plotdata(): data(MEDIUM), userFunction(0),userBinFunction(0){}
+ inline Plotdata(): data(MEDIUM), ext(0), userFunction(0),userBinFunction(0),cached(false){}
  Plotdata(float_t min, float_t max, Grain grain=MEDIUM);
- Plotdata(const float_t*array, int dataSize);
- inline Plotdata(size_t s): data(s), userFunction(0),userBinFunction(0){}
- inline Plotdata(vector<float_t> d): data(d),userFunction(0), userBinFunction(0){};
+ Plotdata(const float_t*array, size_t dataSize);
+ inline Plotdata(size_t s): data(s), ext(0), userFunction(0),userBinFunction(0),cached(false){}
+ inline Plotdata(const PlotBuffer&d): data(d), ext(0), userFunction(0), userBinFunction(0),cached(false){};
+ inline Plotdata(PlotBuffer&&d): data(std::move(d)), ext(0), userFunction(0), userBinFunction(0),cached(false){};
+#ifdef PLOT_POOL
+ inline Plotdata(const vector<float_t>&d): data(d.begin(),d.end()), ext(0), userFunction(0), userBinFunction(0),cached(false){};
+#endif
+ Plotdata(const Plotdata &) = default;
+ Plotdata(Plotdata &&);
+ template<class E> Plotdata(const PlotExpr<E>&e): ext(0), userFunction(0), userBinFunction(0),cached(false) {assign(e.self());}
     // Member Functions
- void insert(const float_t array[], int dataSize);
- inline size_t size() const {return data.size();}
- inline void point(float_t p) {data.push_back(p);}
+ void insert(const float_t array[], size_t dataSize);
+ inline size_t size() const {return ringCap ? ringSize : ext ? extSize : data.size();}
+ inline float_t operator[](size_t i) const {return begin()[i];}
+ inline const float_t* begin() const {return ringCap ? data.data()+ringHead : ext ? ext : data.data();}
+ inline const float_t* end() const {return begin()+size();}
+ inline const float_t* block(size_t i0,size_t,float_t*) const {return begin()+i0;}
+ inline void point(float_t p) {if (ringCap) push(p); else {own(); data.push_back(p); grow(p);}}
+    // Room for n elements in all, so that appends (point(), <<, insert(),
+    // append()) do not reallocate until then; nothing in ring mode
+ void reserve(size_t n) {if (!ringCap) {own(); data.reserve(n);}}
+    // Append n elements, to be written by the caller through the pointer
+    // returned to the first, valid until the next change; ends ring mode
+ float_t* append(size_t n);
  void plotRange(float_t min,float_t max,size_t numPoints,bool isLog = false);
 
- inline void clear() {data.clear();}
- inline const vector<float_t> & getData() const{return data;}
+ void clear();
+ inline const PlotBuffer & getData() const{own(); return data;}
+
+    // Binary files (format in PlotFile.h), false on failure.
+    // open() maps the file: O(1), the elements are read from the file
+    // as they are used, until the Plotdata is first changed.
+ bool save(const char*path) const;
+ bool open(const char*path);
+
+    // Text files of numbers in columns, separated by blanks, or by commas
+    // or semicolons with optional blanks (CSV); an empty field is NOPLOT.
+    // Field k of each line goes to *cols[k]; more fields are ignored.
+    // Blank lines, lines starting with '#', and a first line that is not
+    // numbers (a header) are skipped. Malformed lines are skipped too and
+    // their numbers (from 1) put in *bad. false if the file cannot be read.
+ static bool load(const char*path, Plotdata*const cols[], unsigned n, vector<size_t>*bad=0);
+ static bool load(const char*path, Plotdata&x, Plotdata&y, vector<size_t>*bad=0);
+ bool load(const char*path, vector<size_t>*bad=0);	// one column
+
+    // Ring mode, for live data: keep the last "capacity" elements only,
+    // appends (point(), <<, insert()) overwriting the oldest ones. Memory
+    // and the cost of an append then stay constant, however long the feed.
+    // Other changes (assignment, plotRange(), open(), load(), getData())
+    // end ring mode, as does ring(0).
+ void ring(size_t capacity);
+ inline size_t capacity() const {return ringCap;}
  inline Func & userfunc() { return userFunction; }
  inline BinFunc & userBinfunc() { return userBinFunction; }
 
  Plotdata doFunc(Func aFunction) const;
  Plotdata doBinFunc(BinFunc aFunction, float_t operand2) const;
  Plotdata doBinFunc(float_t operand2) const;
+    // The same for any callable: a lambda, with captures or not, or a
+    // function object, called directly, so that it can be inlined
+ template<class F> Plotdata doFunc(F&&aFunction) const {
+  Plotdata ret(size());
+  callEach(begin(), ret.data.data(), size(), aFunction);
+  return ret;
+ }
+ template<class F> Plotdata doBinFunc(F&&aFunction, float_t operand2) const {
+  PlotBind<typename decay<F>::type> b={aFunction,operand2};
+  return doFunc(b);
+ }
+
+    // Points of f over [lo,hi] for a plot of width x height pixels, into
+    // x and y: few where the curve is straight, more where it bends, so
+    // that the lines between them stay within "tolerance" pixels of it.
+    // A NOPLOT breaks the line where f jumps (see plotsample.cpp).
+ static void sample(Func f, float_t lo, float_t hi, Plotdata&x, Plotdata&y,
+                    int width=640, int height=480, float_t tolerance=0.5);
+    // The same for f(x,op2)
+ static void sample(BinFunc f, float_t op2, float_t lo, float_t hi, Plotdata&x, Plotdata&y,
+                    int width=640, int height=480, float_t tolerance=0.5);
 
 // A 揜ange?class to find min/max of data and to test insideness
  struct Range{
@@ -178,16 +269,136 @@ public:
     // Class (static) functions
     // Retrieves the range of each of x and y in a Plotdata pair
     // Values corresponding to a NAN in the other Plotdata are not included
+    // O(1) when both are unchanged since the last call, or only appended to
  static void rangeXY(const Plotdata&, const Plotdata&,
                     Range&, Range&);
+    // The same for views (PlotView.h), always a scan
+ static void rangeXY(const Plotview&, const Plotview&,
+                    Range&, Range&);
 
- vector<float_t> data;
 private:
+ // Elements of user function calls per chunk, when parallel: user
+ // functions may take microseconds, so a chunk is worth a thread switch
+ static const size_t callChunk=256;
+ // out[i]=f(in[i]) for i<n, on several threads if plotParallelCalls()
+ template<class F> static void callEach(const float_t*in, float_t*out, size_t n, F f) {
+  if (!plotParallelCalls() || n<=callChunk) {
+   transform(in, in+n, out, f);
+   return;
+  }
+  plotParallelChunks(n,callChunk,[&](size_t i0,size_t i1){
+   transform(in+i0, in+i1, out+i0, f);
+  });
+ }
+ // Elements: data, or extSize elements at ext in a mapped file, or the
+ // window of a ring. Changes copy mapped or ring elements into a plain
+ // data first (own()); so does getData(), hence "mutable".
+ mutable PlotBuffer data;
+ mutable const float_t*ext;
+ mutable size_t extSize;
+ mutable shared_ptr<const PlotMap> mapping;
+ void own() const {if (ext || ringCap) copyIn();}
+ void copyIn() const;
+ void release() {ext=0; mapping.reset(); ringCap=0;}	// before refilling data
+ void take(Plotdata &);
+ // Room for n more elements in data, growing geometrically
+ void room(size_t n) {
+  if (data.capacity()-data.size()<n) data.reserve(max(data.size()+n,2*data.capacity()));
+ }
+ // Ring mode: data holds 2*ringCap elements, each one stored at p and
+ // p+ringCap, so that the ringSize elements from ringHead (the oldest)
+ // are always contiguous. For each block of ringBlock ring positions,
+ // the range of the elements written since the block was last entered:
+ // with the old elements left in the block being written to, that is
+ // the range of the window, in O(ringCap/ringBlock+ringBlock).
+ static const size_t ringBlock=4096;
+ struct RingBlock{Range r; size_t nonfinite;};
+ mutable size_t ringCap=0, ringHead=0, ringSize=0;
+ mutable vector<RingBlock> ringBlocks;
+ void push(float_t v);
+ void ringRange() const;
  Func userFunction;		// Any user-designed unary function
  BinFunc userBinFunction;	// Any user-designed binary function
+    // Range of the finite elements of data, and number of the others.
+    // Appends keep it up to date, other changes clear "cached";
+    // rangeXY() recomputes it when needed.
+ mutable Range cache;
+ mutable size_t nonfinite;
+ mutable bool cached;
+ void grow(float_t v) {
+  if (!cached) return;
+  if (isfinite(v)) cache.expand(v); else nonfinite++;
+ }
+ void recache() const;
+    // Evaluate an expression into data, block by block (see PlotExpr.h).
+    // Safe when *this is itself an operand: a block is complete before
+    // it is stored, and the size can only shrink. So is evaluating into
+    // a temporary operand (donor()), which then gives its elements.
+ template<class E> void assign(const E&e) {
+  size_t n=e.size();
+  Plotdata*d=e.donor();
+  if (d && d!=this && d->size()==n && !d->ext && !d->ringCap) {
+   evaluate(e,d->data.data(),n);
+   d->cached=false;
+   release();
+   data.swap(d->data);
+   cached=false;
+   return;
+  }
+  own();
+  cached=false;
+  if (n>data.capacity()) data.clear();	// nothing to keep when it grows
+  data.resize(n);
+  evaluate(e,data.data(),n);
+ }
+ template<class E> static void evaluate(const E&e, float_t*out, size_t n) {
+  float_t buf[PLOT_BLOCK];
+  for (size_t i=0; i<n; i+=PLOT_BLOCK) {
+   size_t m=n-i<PLOT_BLOCK ? n-i : PLOT_BLOCK;
+   const float_t*p=e.block(i,m,buf);
+   if (p!=out+i) copy(p,p+m,out+i);
+  }
+ }
 };
 
-Plotdata operator + (float_t op1, const Plotdata & pd);
-Plotdata operator - (float_t op1, const Plotdata & pd);
-Plotdata operator * (float_t op1, const Plotdata & pd);
-Plotdata operator / (float_t op1, const Plotdata & pd);
+// A temporary Plotdata in an expression: read as a Plotdata, and its
+// elements may be overwritten by the result, and taken (assign())
+class PlotTemp:public PlotExpr<PlotTemp>{
+ Plotdata&d;
+public:
+ explicit PlotTemp(Plotdata&t):d(t) {}
+ Plotdata*donor() const {return &d;}
+ size_t size() const {return d.size();}
+ float_t operator[](size_t i) const {return d[i];}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {return d.block(i0,n,buf);}
+};
+
+// Operators on temporaries, as those of PlotExpr.h
+#define PLOT_TEMP_OP(op,Op) \
+template<class R> inline PlotBinary<PlotTemp,R,Op> \
+ operator op(Plotdata&&a,const PlotExpr<R>&b) {return PlotBinary<PlotTemp,R,Op>(PlotTemp(a),b.self());} \
+template<class L> inline PlotBinary<L,PlotTemp,Op> \
+ operator op(const PlotExpr<L>&a,Plotdata&&b) {return PlotBinary<L,PlotTemp,Op>(a.self(),PlotTemp(b));} \
+inline PlotBinary<PlotTemp,PlotTemp,Op> \
+ operator op(Plotdata&&a,Plotdata&&b) {return PlotBinary<PlotTemp,PlotTemp,Op>(PlotTemp(a),PlotTemp(b));} \
+inline PlotScalarR<PlotTemp,Op> \
+ operator op(Plotdata&&a,float_t b) {return PlotScalarR<PlotTemp,Op>(PlotTemp(a),b);} \
+inline PlotScalarL<PlotTemp,Op> \
+ operator op(float_t a,Plotdata&&b) {return PlotScalarL<PlotTemp,Op>(a,PlotTemp(b));}
+PLOT_TEMP_OP(+,PlotAdd)
+PLOT_TEMP_OP(-,PlotSub)
+PLOT_TEMP_OP(*,PlotMul)
+PLOT_TEMP_OP(/,PlotDiv)
+#undef PLOT_TEMP_OP
+
+inline PlotScalarR<PlotTemp,PlotPow>
+ operator ^ (Plotdata&&a,float_t val) {return PlotScalarR<PlotTemp,PlotPow>(PlotTemp(a),val);}
+inline PlotUnary<PlotTemp,PlotNeg>
+ operator - (Plotdata&&a) {return PlotUnary<PlotTemp,PlotNeg>(PlotTemp(a));}
+
+// Non-owning, strided views of elements
+#include "PlotView.h"
+// Compact data: float, scaled integers
+#include "PlotSamples.h"
+// Data read from a file in chunks
+#include "PlotChunks.h"
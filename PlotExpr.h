@@ -0,0 +1,209 @@
+/* File: PlotExpr.h
+ *
+ * Lazy element-wise expressions over Plotdata.
+ *
+ * The arithmetic operators and the maths functions of koolplot do not
+ * compute anything by themselves: they return small expression objects
+ * that remember their operands. The whole expression is evaluated in a
+ * single pass, without intermediate vectors, when it is assigned to
+ * (or used to construct) a Plotdata.
+ *
+ * The pass goes by blocks of PLOT_BLOCK elements, small enough to stay in
+ * the L1 cache. Each operation of the expression runs over a whole block
+ * at once through the SIMD kernels of PlotKernels.h.
+ *
+ * Example:
+ *		Plotdata x(-5.0, 2.0), y = x*x + 3*x + 3;	// one pass, one allocation
+ *
+ * Plotdata operands are held by reference, sub-expressions by value.
+ * Do not keep an expression object beyond the lifetime of its operands.
+ * The result takes the elements of a temporary Plotdata operand of its
+ * size, such as that of doFunc() in x.doFunc(f)*2, rather than allocate.
+ *
+ * This file is included by PlotData.h and is not meant to be used alone.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+
+#include "PlotKernels.h"
+
+class Plotdata;
+
+// Base of every expression (including Plotdata itself), static polymorphism
+template<class E> struct PlotExpr{
+ const E&self() const {return static_cast<const E&>(*this);}
+	// a temporary Plotdata operand, whose elements the result may take
+	// (PlotTemp in PlotData.h), or 0
+ Plotdata*donor() const {return 0;}
+};
+
+// How an operand is stored inside an expression node:
+// sub-expressions are cheap to copy, Plotdata is referenced.
+template<class E> struct PlotExprRef{typedef const E type;};
+template<> struct PlotExprRef<Plotdata>{typedef const Plotdata&type;};
+
+/* -------------------------------------------------------- */
+// Element operations, and their kernel in PlotKernels.h
+struct PlotAdd{enum{kernel=PK_ADD}; static float_t apply(float_t a,float_t b) {return a+b;}};
+struct PlotSub{enum{kernel=PK_SUB}; static float_t apply(float_t a,float_t b) {return a-b;}};
+struct PlotMul{enum{kernel=PK_MUL}; static float_t apply(float_t a,float_t b) {return a*b;}};
+struct PlotDiv{enum{kernel=PK_DIV}; static float_t apply(float_t a,float_t b) {return a/b;}};
+struct PlotPow{enum{kernel=PK_POW}; static float_t apply(float_t a,float_t b) {	// as the kernel does
+ float_t r;
+ return plotKernelVS(PK_POW,&a,b,&r,1) ? r : std::pow(a,b);
+}};
+struct PlotNeg{enum{kernel=PK_NEG}; static float_t apply(float_t a) {return -a;}};
+
+// math.h functions usable in expressions (see koolplot.h)
+#define PLOT_EXPR_FUNC(Name,fn,k) \
+ struct Name{enum{kernel=k}; static float_t apply(float_t a) {return std::fn(a);}};
+PLOT_EXPR_FUNC(PlotSin,sin,PK_SIN)
+PLOT_EXPR_FUNC(PlotCos,cos,PK_COS)
+PLOT_EXPR_FUNC(PlotTan,tan,PK_TAN)
+PLOT_EXPR_FUNC(PlotAsin,asin,PK_ASIN)
+PLOT_EXPR_FUNC(PlotAcos,acos,PK_ACOS)
+PLOT_EXPR_FUNC(PlotAtan,atan,PK_ATAN)
+PLOT_EXPR_FUNC(PlotSinh,sinh,PK_SINH)
+PLOT_EXPR_FUNC(PlotCosh,cosh,PK_COSH)
+PLOT_EXPR_FUNC(PlotTanh,tanh,PK_TANH)
+PLOT_EXPR_FUNC(PlotSqrt,sqrt,PK_SQRT)
+PLOT_EXPR_FUNC(PlotFabs,fabs,PK_FABS)
+PLOT_EXPR_FUNC(PlotLog,log,PK_LOG)
+PLOT_EXPR_FUNC(PlotLog10,log10,PK_LOG10)
+PLOT_EXPR_FUNC(PlotExp,exp,PK_EXP)
+#undef PLOT_EXPR_FUNC
+
+/* -------------------------------------------------------- */
+// Expression nodes
+//
+// Besides size() and operator[], each node computes a block of elements:
+// block(i0,n,buf) returns a pointer to elements i0..i0+n-1 (n <= PLOT_BLOCK)
+// of the expression, written to buf, or taken directly from a Plotdata.
+
+const size_t PLOT_BLOCK=256;
+
+// expr op expr; size is that of the smallest of the two
+template<class L,class R,class Op> class PlotBinary:public PlotExpr<PlotBinary<L,R,Op> >{
+ typename PlotExprRef<L>::type l;
+ typename PlotExprRef<R>::type r;
+public:
+ PlotBinary(const L&a,const R&b):l(a),r(b) {}
+ const L&left() const {return l;}
+ const R&right() const {return r;}
+ Plotdata*donor() const {Plotdata*d=l.donor(); return d ? d : r.donor();}
+ size_t size() const {return l.size()<r.size() ? l.size() : r.size();}
+ float_t operator[](size_t i) const {return Op::apply(l[i],r[i]);}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {
+  float_t tmp[PLOT_BLOCK];
+  const float_t*a=l.block(i0,n,buf),*b=r.block(i0,n,tmp);
+  if (!plotKernelVV(Op::kernel,a,b,buf,n))
+   for (size_t i=0; i<n; i++) buf[i]=Op::apply(a[i],b[i]);
+  return buf;
+ }
+};
+
+// expr op scalar
+template<class L,class Op> class PlotScalarR:public PlotExpr<PlotScalarR<L,Op> >{
+ typename PlotExprRef<L>::type l;
+ float_t r;
+public:
+ PlotScalarR(const L&a,float_t b):l(a),r(b) {}
+ const L&left() const {return l;}
+ float_t right() const {return r;}
+ Plotdata*donor() const {return l.donor();}
+ size_t size() const {return l.size();}
+ float_t operator[](size_t i) const {return Op::apply(l[i],r);}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {
+  const float_t*a=l.block(i0,n,buf);
+  if (!plotKernelVS(Op::kernel,a,r,buf,n))
+   for (size_t i=0; i<n; i++) buf[i]=Op::apply(a[i],r);
+  return buf;
+ }
+};
+
+// scalar op expr
+template<class R,class Op> class PlotScalarL:public PlotExpr<PlotScalarL<R,Op> >{
+ float_t l;
+ typename PlotExprRef<R>::type r;
+public:
+ PlotScalarL(float_t a,const R&b):l(a),r(b) {}
+ float_t left() const {return l;}
+ const R&right() const {return r;}
+ Plotdata*donor() const {return r.donor();}
+ size_t size() const {return r.size();}
+ float_t operator[](size_t i) const {return Op::apply(l,r[i]);}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {
+  const float_t*b=r.block(i0,n,buf);
+  if (!plotKernelSV(Op::kernel,l,b,buf,n))
+   for (size_t i=0; i<n; i++) buf[i]=Op::apply(l,b[i]);
+  return buf;
+ }
+};
+
+// op expr
+template<class E,class Op> class PlotUnary:public PlotExpr<PlotUnary<E,Op> >{
+ typename PlotExprRef<E>::type e;
+public:
+ explicit PlotUnary(const E&a):e(a) {}
+ const E&operand() const {return e;}
+ Plotdata*donor() const {return e.donor();}
+ size_t size() const {return e.size();}
+ float_t operator[](size_t i) const {return Op::apply(e[i]);}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {
+  const float_t*a=e.block(i0,n,buf);
+  if (!plotKernelV(Op::kernel,a,buf,n))
+   for (size_t i=0; i<n; i++) buf[i]=Op::apply(a[i]);
+  return buf;
+ }
+};
+
+// fn(expr) for any callable fn, held by value: a lambda, with captures
+// or not, or a function object is called in the block loop directly,
+// where the compiler can inline it (see f() in koolplot.h)
+template<class E,class F> class PlotCall:public PlotExpr<PlotCall<E,F> >{
+ typename PlotExprRef<E>::type e;
+ mutable F f;
+public:
+ PlotCall(const E&a,const F&fn):e(a),f(fn) {}
+ const E&operand() const {return e;}
+ Plotdata*donor() const {return e.donor();}
+ size_t size() const {return e.size();}
+ float_t operator[](size_t i) const {return f(e[i]);}
+ const float_t*block(size_t i0,size_t n,float_t*buf) const {
+  const float_t*a=e.block(i0,n,buf);
+  for (size_t i=0; i<n; i++) buf[i]=f(a[i]);
+  return buf;
+ }
+};
+
+// fn(v,op2) as a callable of v
+template<class F> struct PlotBind{
+ mutable F f;
+ float_t op2;
+ float_t operator()(float_t v) const {return f(v,op2);}
+};
+
+/* -------------------------------------------------------- */
+// Operators
+
+#define PLOT_EXPR_OP(op,Op) \
+template<class L,class R> inline PlotBinary<L,R,Op> \
+ operator op(const PlotExpr<L>&a,const PlotExpr<R>&b) {return PlotBinary<L,R,Op>(a.self(),b.self());} \
+template<class L> inline PlotScalarR<L,Op> \
+ operator op(const PlotExpr<L>&a,float_t b) {return PlotScalarR<L,Op>(a.self(),b);} \
+template<class R> inline PlotScalarL<R,Op> \
+ operator op(float_t a,const PlotExpr<R>&b) {return PlotScalarL<R,Op>(a,b.self());}
+PLOT_EXPR_OP(+,PlotAdd)
+PLOT_EXPR_OP(-,PlotSub)
+PLOT_EXPR_OP(*,PlotMul)
+PLOT_EXPR_OP(/,PlotDiv)
+#undef PLOT_EXPR_OP
+
+// Raise each element to the power "val"
+template<class L> inline PlotScalarR<L,PlotPow>
+ operator ^ (const PlotExpr<L>&a,float_t val) {return PlotScalarR<L,PlotPow>(a.self(),val);}
+
+template<class E> inline PlotUnary<E,PlotNeg>
+ operator - (const PlotExpr<E>&a) {return PlotUnary<E,PlotNeg>(a.self());}
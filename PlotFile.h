@@ -0,0 +1,53 @@
+/* File: PlotFile.h
+ *
+ * Binary files of Plotdata (Plotdata::save() and Plotdata::open()),
+ * and class PlotMap, a file mapped into memory read-only.
+ *
+ * File layout, in the byte order of the machine that wrote it:
+ *	PlotFileHeader	64 bytes
+ *	count elements	of the given type, from byte 64
+ *
+ * open() maps the file and uses its elements where they are, so opening
+ * takes the same time for any size and only the pages used are read.
+ * This needs elements of the type of float_t; files of the other type
+ * are read and converted. The cached range in the header, when present,
+ * makes Plotdata::rangeXY() O(1) on the opened data.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+
+struct PlotFileHeader{
+ enum{VERSION=1, ORDER=0x0102};
+ enum Type{FLOAT32=1, FLOAT64=2};
+ enum Flags{RANGE=1};		// min, max and nonfinite are valid
+ char magic[8];			// "KOOLPLOT"
+ uint16_t version;
+ uint16_t order;		// ORDER, as written by this machine
+ uint32_t type;
+ uint64_t count;		// number of elements
+ uint32_t flags;
+ uint32_t reserved;
+ double min,max;		// of the finite elements
+ uint64_t nonfinite;		// number of NOPLOT and infinite elements
+ uint64_t reserved2;
+};
+
+class PlotMap{
+public:
+	/* Map all of path; check ok() */
+ PlotMap(const char*path);
+ ~PlotMap();
+ bool ok() const {return p!=0;}
+ const unsigned char*data() const {return (const unsigned char*)p;}
+ size_t size() const {return n;}
+private:
+ void*p;
+ size_t n;
+#ifdef _WIN32
+ void*file,*map;	// HANDLEs
+#endif
+ PlotMap(const PlotMap&);
+ void operator=(const PlotMap&);
+};
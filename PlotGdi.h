@@ -0,0 +1,60 @@
+/* File: PlotGdi.h
+ *
+ * Class PlotGdi
+ * A PlotCanvas drawing on a Windows device context,
+ * used by Plotstream::onPaint(). Windows only.
+ *
+ * Its layers are bitmaps in memory device contexts, so a Plotstream
+ * draws the whole frame off-screen and copies it to the window in one
+ * BitBlt, without flicker. Pens and the font are made once per PlotGdi
+ * and kept; the ones kept by Plotstream live as long as it.
+ *
+ * The pen, font and text settings of the device context are restored
+ * when the PlotGdi is destroyed.
+ */
+#pragma once
+
+#include "PlotCanvas.h"
+
+#ifdef _WIN32
+
+class PlotGdi:public PlotCanvas{
+public:
+	/* Draw on dc, whose drawing area is the client area of wnd */
+ PlotGdi(HDC dc, HWND wnd);
+	/* Draw on a bitmap of width x height, compatible with dc */
+ PlotGdi(HDC dc, int width, int height);
+ ~PlotGdi();
+ int width() const;
+ int height() const;
+ void erase(Color colour=WHITE);
+ void pen(Color colour, int width=1, PenStyle style=SOLID);
+ void moveto(int x, int y) {MoveToEx(dc,x,y,0);}
+ void lineto(int x, int y) {LineTo(dc,x,y);}
+ void rectangle(int l, int t, int r, int b, Color fill=WHITE);
+ void text(int x, int y, const char*s, TextAlign align=LEFT, Color colour=BLACK);
+ void textSize(const char*s, int&cx, int&cy);
+ void clip(int l, int t, int r, int b);
+ void unclip() {SelectClipRgn(dc,0);}
+ PlotCanvas*layer() const;
+ bool copy(const PlotCanvas&layer);
+private:
+ struct Pen{
+  Color colour;
+  int width;
+  PenStyle style;
+  HPEN h;
+ };
+ HDC dc;
+ RECT rc;		// client area
+ HBITMAP bitmap, obitmap;	// of a layer, bitmap of dc before
+ std::vector<Pen> pens;	// made so far
+ HPEN open;		// pen of dc before
+ HFONT font, ofont;	// label font, font of dc before; made when first used
+ int obkmode;
+ void useFont();
+ PlotGdi(const PlotGdi&);
+ void operator=(const PlotGdi&);
+};
+
+#endif
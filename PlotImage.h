@@ -0,0 +1,31 @@
+/* File: PlotImage.h
+ *
+ * Writing of rendered plots (PlotRaster images) to image files:
+ * binary PPM (P6), and PNG (8 bit RGB).
+ *
+ * PNG compression is done here, without zlib: the image is cut into
+ * stripes of rows that are filtered and deflated independently, on
+ * several threads (PlotThreads.h), then joined into one zlib stream.
+ * Working buffers are kept from one image to the next (one set per
+ * calling thread), so writing many images allocates nothing once the
+ * first one is done.
+ *
+ * The functions return false when the file cannot be written.
+ */
+#pragma once
+
+#include <vector>
+
+#include "PlotRaster.h"
+
+/** Write img as binary PPM */
+bool plotSavePpm(const PlotRaster&img, const char*path);
+
+/** Write img as PNG */
+bool plotSavePng(const PlotRaster&img, const char*path);
+
+/** Write img as PPM if path ends in .ppm or .pnm, as PNG otherwise */
+bool plotSaveImage(const PlotRaster&img, const char*path);
+
+/** PNG file contents of img, in memory */
+void plotEncodePng(const PlotRaster&img, std::vector<unsigned char>&png);
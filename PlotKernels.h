@@ -0,0 +1,92 @@
+/* File: PlotKernels.h
+ *
+ * Element-wise kernels behind the Plotdata arithmetic operators.
+ *
+ * Each kernel exists as plain C++ and as SSE2, AVX2 and AVX-512 code.
+ * The best instruction set supported by the processor (and the OS) is
+ * chosen from CPUID the first time a kernel is used. PlotExpr.h runs
+ * every operation of an expression through these kernels, one block
+ * of elements at a time.
+ *
+ * The math functions (PK_SIN ... PK_EXP) have their own vectorized
+ * implementation; see plotmath.inl for the accuracy of each one.
+ *
+ * This file is included by PlotData.h and is not meant to be used alone.
+ */
+#pragma once
+
+#include <cstddef>
+
+/** Operations known to the kernels */
+enum PlotKernelOp{
+ PK_NONE,	// no kernel, use the generic loop
+ PK_ADD,
+ PK_SUB,
+ PK_MUL,
+ PK_DIV,
+ PK_POW,	// vector ^ scalar only
+	// unary only
+ PK_NEG,
+ PK_SIN,
+ PK_COS,
+ PK_TAN,
+ PK_ASIN,
+ PK_ACOS,
+ PK_ATAN,
+ PK_SINH,
+ PK_COSH,
+ PK_TANH,
+ PK_SQRT,
+ PK_FABS,
+ PK_LOG,
+ PK_LOG10,
+ PK_EXP
+};
+
+/** Instruction set levels, in increasing order */
+enum PlotIsa{
+ ISA_SCALAR,
+ ISA_SSE2,
+ ISA_AVX2,
+ ISA_AVX512
+};
+
+/** Best instruction set usable on this machine */
+PlotIsa plotIsaDetected();
+
+/** Instruction set currently used by the kernels */
+PlotIsa plotIsa();
+
+/**
+ * Force the kernels to a lower instruction set (for benchmarks and tests).
+ * Requests above plotIsaDetected() are clamped.
+ * @return the instruction set actually selected
+ */
+PlotIsa plotSetIsa(PlotIsa isa);
+
+/** Readable name of an instruction set level */
+const char*plotIsaName(PlotIsa isa);
+
+/*
+ * Kernels: o[i] = a[i] op b[i], a[i] op s, s op b[i], op a[i].
+ * o may be the same array as a or b.
+ * Return false when op has no kernel in that form; o is untouched then.
+ */
+bool plotKernelVV(int op, const float_t*a, const float_t*b, float_t*o, size_t n);
+bool plotKernelVS(int op, const float_t*a, float_t s, float_t*o, size_t n);
+bool plotKernelSV(int op, float_t s, const float_t*b, float_t*o, size_t n);
+bool plotKernelV(int op, const float_t*a, float_t*o, size_t n);
+
+/*
+ * Range of x[i] and y[i] over the pairs where both are finite:
+ * r = {min x, max x, min y, max y}, {inf,-inf,inf,-inf} if there are none.
+ * With y = 0, range of the finite x[i] alone; r[2] and r[3] are then
+ * meaningless. Large arrays are split across threads (PlotThreads.h).
+ * The result is the same as that of a plain loop keeping the first of
+ * equal values. @return the number of pairs taken.
+ */
+size_t plotKernelRange(const float_t*x, const float_t*y, size_t n, float_t r[4]);
+
+/** The same with x[i] and y[i] xs and ys bytes apart from x[i-1] and y[i-1] */
+size_t plotKernelRange(const float_t*x, size_t xs, const float_t*y, size_t ys,
+                       size_t n, float_t r[4]);
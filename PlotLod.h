@@ -0,0 +1,68 @@
+/* File: PlotLod.h
+ *
+ * Class PlotLod
+ * Levels of detail of an x/y trace, so that huge traces are drawn in time
+ * proportional to the pixels rather than to the points: for blocks of
+ * base, 2*base, 4*base... consecutive points, the extent of x and y and
+ * the first and last y of the block (a min/max pyramid). Level k+1
+ * is made of pairs of blocks of level k.
+ *
+ * Plotstream draws a block whose x extent falls within one pixel column
+ * from its entry alone, as its first, lowest, highest and last point,
+ * which is what decimation would have kept of it (see Plotstream::pyramid()).
+ * Starting from the coarsest level and splitting only blocks that cross
+ * columns, a trace of n points sorted by x takes about pixels * log(n)
+ * entries to draw.
+ *
+ * Building reads every point once, on several threads (PlotThreads.h),
+ * and finds out on the way whether x is sorted (for Plotstream::view()).
+ * The pyramid takes about 1/35 of the memory of a trace of float.
+ *
+ * Example:
+ *		PlotLod lod;
+ *		lod.build(Plotview(x), Plotview(y));
+ *		lod.size();		// points summarized, the last ones left out
+ *		lod.range(Plotview(x), Plotview(y), x.size(), xr, yr);	// no full scan
+ */
+#pragma once
+
+#include "PlotData.h"
+
+class PlotLod{
+public:
+ static const size_t base=PLOT_BLOCK;	// points per block of level 0
+ struct Entry{
+  float_t xmin,xmax,ymin,ymax;	// of the block, when it is whole
+  float_t first,last;		// y of its first and last point
+  bool broken;			// a point is not finite (NOPLOT): use the points
+  bool minFirst;		// ymin comes before ymax
+ };
+ PlotLod():n(0),ordered(false) {}
+	/* Summarize x and y, as many whole blocks of base points as they hold */
+ void build(const Plotview&x, const Plotview&y);
+ void clear() {n=0; ordered=false; level.clear();}
+	/* Points summarized, a multiple of base */
+ size_t size() const {return n;}
+	/* Whether x is finite and never decreases over these points */
+ bool sorted() const {return ordered;}
+ unsigned levels() const {return unsigned(level.size());}
+	/* Block j of level k holds points j*(base<<k) to (j+1)*(base<<k)-1 */
+ size_t count(unsigned k) const {return level[k].size();}
+ const Entry&entry(unsigned k, size_t j) const {return level[k][j];}
+	/* The coarsest level with a block starting at block j of level 0 and
+	   ending by block end; such blocks, one after the other, cover the
+	   blocks from j to end */
+ unsigned top(size_t j, size_t end) const {
+  unsigned k=0;
+  while (k+1<levels() && !(j&((size_t(2)<<k)-1)) && j+(size_t(2)<<k)<=end) k++;
+  return k;
+ }
+	/* Ranges of the finite points among the first ones of x and y
+	   (at least size()), reading only those that are not summarized */
+ void range(const Plotview&x, const Plotview&y, size_t points,
+  Plotdata::Range&xr, Plotdata::Range&yr) const;
+private:
+ size_t n;
+ bool ordered;
+ vector<vector<Entry> > level;
+};
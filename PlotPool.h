@@ -0,0 +1,83 @@
+/* File: PlotPool.h
+ *
+ * Pooled memory for the elements of Plotdata, when everything is built
+ * with PLOT_POOL defined (see PlotBuffer in PlotData.h).
+ *
+ * Programs that build and drop many short-lived Plotdata (results of
+ * doFunc(), traces computed anew for each frame) make the heap allocate
+ * and free blocks of the same few sizes over and over, and fragment it
+ * over long runs. With pooling on, freed blocks are kept in free lists,
+ * by size class (four per power of two), and given again to requests of
+ * their class.
+ *
+ * A PlotFrame goes further: while it exists, the elements allocated on
+ * its thread are cut from large chunks one after the other, and freeing
+ * them costs nothing; the chunks are recycled all at once when the frame
+ * ends. Elements that outlive their frame stay valid, their chunk being
+ * kept until they are freed too.
+ *
+ * Example (a plot computed anew for each frame of an animation):
+ *		plotSetPooling(true);
+ *		for (float_t t=0; ; t+=dt) {
+ *			PlotFrame frame;
+ *			Plotdata y = sin(x*t)*exp(-x);
+ *			...
+ *		}
+ *		PlotPoolStats s = plotPoolStats();	// s.reused against s.fresh
+ */
+#pragma once
+
+#include <cstddef>
+
+struct PlotPoolStats{
+ size_t fresh;		// bytes given out from newly allocated memory
+ size_t reused;		// bytes given out again after they were freed
+ size_t held;		// bytes kept, free, in the pool and in idle chunks
+};
+
+/** Whether freed elements are kept for reuse (default: off). Turning
+ *  pooling off gives the memory kept back to the heap. */
+bool plotPooling();
+void plotSetPooling(bool on);
+
+/** Bytes given out since the start, and kept now */
+PlotPoolStats plotPoolStats();
+
+/** Give the memory kept, free, back to the heap */
+void plotPoolTrim();
+
+/** Memory for elements, from the current frame, the pool or the heap;
+ *  throws std::bad_alloc when there is none */
+void*plotAllocate(size_t bytes);
+void plotDeallocate(void*p);
+
+/** Allocator of Plotdata elements, through plotAllocate() */
+template<class T> struct PlotAlloc{
+ typedef T value_type;
+ PlotAlloc() {}
+ template<class U> PlotAlloc(const PlotAlloc<U>&) {}
+ T*allocate(size_t n) {return static_cast<T*>(plotAllocate(n*sizeof(T)));}
+ void deallocate(T*p, size_t) {plotDeallocate(p);}
+};
+template<class T,class U> inline bool operator==(const PlotAlloc<T>&, const PlotAlloc<U>&) {return true;}
+template<class T,class U> inline bool operator!=(const PlotAlloc<T>&, const PlotAlloc<U>&) {return false;}
+
+/**
+ * Frame arena: allocations of its thread, from its construction to its
+ * destruction, are cut from chunks of "chunk" bytes; larger ones (over a
+ * quarter of a chunk) are not. Frames nest; the innermost one is used.
+ */
+class PlotFrame{
+public:
+ explicit PlotFrame(size_t chunk=1<<20);
+ ~PlotFrame();
+	// memory from the chunks, freed by plotDeallocate(); 0 if too large
+ void*allocate(size_t bytes);
+ struct Chunk;
+private:
+ PlotFrame(const PlotFrame&);
+ PlotFrame&operator=(const PlotFrame&);
+ PlotFrame*outer;
+ size_t chunkSize;
+ Chunk*chunks;				// the current one first
+};
@@ -0,0 +1,60 @@
+/* File: PlotRaster.h
+ *
+ * Class PlotRaster
+ * A PlotCanvas drawing into an RGBA image in memory, without any
+ * window system, so that plots can be rendered on any machine.
+ *
+ * Example:
+ *		Plotstream ps;
+ *		ps.addplot(x, y);
+ *		PlotRaster img(800, 600);
+ *		ps.paint(img);		// img.pixels() now holds the plot
+ *
+ * Pixels are 32 bit, 0xAABBGGRR (R, G, B, A in memory order on little
+ * endian machines), the same layout as Color with full alpha.
+ * Text uses a built-in 5x7 dot font, scaled to about 16 pixels high.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "PlotCanvas.h"
+
+class PlotRaster:public PlotCanvas{
+public:
+ PlotRaster(int width, int height, Color background=WHITE);
+	/* Fill the whole image with the background colour */
+ void clear();
+	/* Change the size; the image is cleared */
+ void resize(int width, int height);
+ Color background() const {return bg;}
+ const uint32_t*pixels() const {return px.data();}
+ uint32_t pixel(int x, int y) const {return px[size_t(y)*w+x];}
+
+ int width() const {return w;}
+ int height() const {return h;}
+ void erase(Color colour=WHITE);
+ void pen(Color colour, int width=1, PenStyle style=SOLID);
+ void moveto(int x, int y);
+ void lineto(int x, int y);
+ void rectangle(int l, int t, int r, int b, Color fill=WHITE);
+ void text(int x, int y, const char*s, TextAlign align=LEFT, Color colour=BLACK);
+ void textSize(const char*s, int&cx, int&cy);
+ void clip(int l, int t, int r, int b);
+ void unclip() {clip(0,0,w,h);}
+ PlotCanvas*layer() const {return new PlotRaster(w,h,bg);}
+ bool copy(const PlotCanvas&layer);
+private:
+ int w,h;
+ Color bg;
+ std::vector<uint32_t> px;
+ uint32_t ink;		// pen colour as a pixel
+ int penWidth;
+ PenStyle penStyle;
+ int curX,curY;		// current position
+ int cl,ct,cr,cb;	// lines are drawn within, r and b exclusive
+ unsigned dots;		// position in the dot pattern, continues along a path
+ void plot(int x, int y);	// one pen dot at (x,y)
+ void fill(int l, int t, int r, int b, uint32_t c);	// clipped to the image, r and b exclusive
+};
@@ -0,0 +1,72 @@
+/* File: PlotSamples.h
+ *
+ * Class template Plotsamples
+ * Data for one axis stored compactly, as elements of type T: float, or
+ * int16_t or int32_t samples of an ADC with a gain and an offset, each
+ * standing for the value raw * gain + offset. A 16-bit capture then
+ * takes a quarter of the memory of doubles, and reading it (ranges,
+ * drawing) a quarter of the bandwidth.
+ *
+ * Example:
+ *		Plotint16 volts(0.001, -2.5);	// 1 mV per step, from -2.5 V
+ *		volts.insert(adc, count);	// raw int16_t samples
+ *		Plotdata t;
+ *		t.plotRange(0, count*dt, count);
+ *		ps.addplot(Plotview(t), volts);
+ *		Plotdata watts = volts*volts/50;	// expressions convert
+ *
+ * NOPLOT is stored as the smallest integer of T (PlotElement<T>::none()),
+ * which point() never gives to a value: values are rounded to the
+ * nearest step and clamped to the other integers of T.
+ *
+ * Plotsamples can be used in expressions (PlotExpr.h), like Plotdata,
+ * and plotted by Plotstream; both read them through a Plotview, which
+ * converts a block at a time, so the values are float_t only in cache.
+ * A Plotstream plots them as they are when added, as views; the data
+ * must stay, unchanged, until the Plotstream is done with it.
+ *
+ * This file is included by PlotData.h and is not meant to be used alone.
+ */
+#pragma once
+
+template<class T> class Plotsamples:public PlotExpr<Plotsamples<T> >{
+public:
+	/* value = raw * gain + offset */
+ explicit Plotsamples(float_t gain=1, float_t offset=0):g(gain),o(offset) {}
+ size_t size() const {return v.size();}
+ float_t gain() const {return g;}
+ float_t offset() const {return o;}
+ void reserve(size_t n) {v.reserve(n);}
+ void clear() {v.clear();}
+	/* Raw elements */
+ const T*raw() const {return v.data();}
+ void sample(T raw) {v.push_back(raw);}
+ void insert(const T raws[], size_t count) {v.insert(v.end(),raws,raws+count);}
+	/* Append a value, stored as the nearest raw element */
+ void point(float_t value) {v.push_back(toRaw(value));}
+ T toRaw(float_t value) const {return toRaw(value,(T*)0);}
+
+ Plotview view() const {return Plotview(v.data(),v.size(),sizeof(T),g,o);}
+ float_t operator[](size_t i) const {return view()[i];}
+ const float_t*block(size_t i0, size_t m, float_t*buf) const {return view().block(i0,m,buf);}
+private:
+ vector<T> v;
+ float_t g,o;
+ template<class U> T toRaw(float_t value, U*) const {	// integers
+  if (!isfinite(value)) return PlotElement<T>::none();
+  double r=floor((double(value)-o)/g+0.5);
+  double lo=double(numeric_limits<T>::min())+1, hi=double(numeric_limits<T>::max());
+  return T(r<lo ? lo : r>hi ? hi : r);
+ }
+ T toRaw(float_t value, float*) const {return float((value-o)/g);}
+ T toRaw(float_t value, double*) const {return double((value-o)/g);}
+};
+
+template<class T> inline Plotview::Plotview(const Plotsamples<T>&s) {*this=s.view();}
+
+// Plotsamples are referenced in expressions, as Plotdata
+template<class T> struct PlotExprRef<Plotsamples<T> >{typedef const Plotsamples<T>&type;};
+
+typedef Plotsamples<float> Plotfloat;
+typedef Plotsamples<int16_t> Plotint16;
+typedef Plotsamples<int32_t> Plotint32;
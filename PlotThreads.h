@@ -0,0 +1,65 @@
+/* File: PlotThreads.h
+ *
+ * Splitting of large loops over Plotdata across processor cores.
+ *
+ * A loop over n elements is cut into at most plotThreads() parts of
+ * consecutive elements; all parts but the first run on threads of their
+ * own, the first one on the calling thread, and plotParallel() returns
+ * when all are done.
+ *
+ * Example (sum of a large array, one partial sum per part):
+ *		unsigned parts=plotParts(n,1<<16);
+ *		vector<double> sum(parts);
+ *		plotParallel(parts,n,[&](unsigned k,size_t i0,size_t i1){
+ *			for (size_t i=i0; i<i1; i++) sum[k]+=a[i];
+ *		});
+ *
+ * Loops whose elements cost unevenly, such as calls of user functions,
+ * are better cut into many small chunks with plotParallelChunks(): the
+ * threads of a pool, kept from one call to the next, share them out.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/** Number of threads used for large loops (default: number of cores) */
+unsigned plotThreads();
+
+/** Set the number of threads used for large loops, 1 to disable threading */
+void plotSetThreads(unsigned n);
+
+/**
+ * Number of parts worth splitting n elements into,
+ * each part having at least minPart elements
+ */
+unsigned plotParts(size_t n, size_t minPart);
+
+/**
+ * Call f(k,i0,i1) for each part k < parts of [0,n), in parallel.
+ * Parts are of near-equal size and in order: part k ends where k+1 begins.
+ * If f throws, the other parts still run, and the first exception is
+ * thrown again once all are done.
+ */
+void plotParallel(unsigned parts, size_t n,
+                  const std::function<void(unsigned,size_t,size_t)>&f);
+
+/**
+ * Call f(i0,i1) for each chunk of [0,n), "chunk" elements long (the last
+ * may be shorter), in parallel, in no particular order. Each of up to
+ * plotThreads() threads (the calling one included) begins with a share
+ * of consecutive chunks, then takes chunks left in the others' shares
+ * (work stealing), so threads that finish early help the slow ones.
+ * Runs on the calling thread alone when called from within f, or while
+ * another thread uses the pool. If f throws, the chunks not yet begun are
+ * left and the first exception is thrown again, once all threads are done.
+ */
+void plotParallelChunks(size_t n, size_t chunk,
+                        const std::function<void(size_t,size_t)>&f);
+
+/** Whether Plotdata::doFunc() and doBinFunc() call the user function on
+ *  several threads at once (plotParallelChunks()); off by default. Only
+ *  for functions that are safe to call so, as pure math functions are.
+ *  The results are the same, in the same order, either way. */
+bool plotParallelCalls();
+void plotSetParallelCalls(bool on);
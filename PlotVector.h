@@ -0,0 +1,128 @@
+/* File: PlotVector.h
+ *
+ * Classes PlotVector, PlotSvg, PlotPdf
+ * PlotCanvases writing the plot as a vector drawing to a file:
+ * PlotSvg as SVG, PlotPdf as a one page PDF.
+ *
+ * Example:
+ *		Plotstream ps;
+ *		ps.addplot(x, y);
+ *		PlotSvg svg("plot.svg", 800, 600);
+ *		ps.paint(svg);
+ *		if (!svg.close()) ...	// could not write
+ *
+ * Plotstream::saveImage() does the same for names ending in .svg or .pdf.
+ *
+ * The lines drawn between two pen changes (one trace, or the grid) make
+ * one path. Its points are simplified as they come (Douglas-Peucker,
+ * within tolerance() pixels) and written out a window of points at a
+ * time, so memory does not grow with the size of the trace.
+ */
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "PlotCanvas.h"
+
+class PlotVector:public PlotCanvas{
+public:
+	/* Write to path, for a drawing area of width x height pixels */
+ PlotVector(const char*path, int width, int height);
+ ~PlotVector();
+	/* false if the file could not be created */
+ bool ok() const {return f!=0;}
+	/* Finish and close the file; false if anything could not be written */
+ bool close();
+	/* Largest distance of a dropped point from the simplified path,
+	   in pixels (default 0.5); 0 drops only points lying on the path */
+ void tolerance(double px) {tol2=px*px;}
+
+ int width() const {return w;}
+ int height() const {return h;}
+ void pen(Color colour, int width=1, PenStyle style=SOLID);
+ void moveto(int x, int y);
+ void lineto(int x, int y);
+ void textSize(const char*s, int&cx, int&cy);
+protected:
+ struct Point{int x,y;};
+ static const int fontSize=16;	// label font height, as PlotGdi
+ static const int fontAscent=14;	// top of the text to its baseline
+ int w,h;
+ Color ink;		// current pen
+ int penWidth;
+ PenStyle penStyle;
+	/* Path output, in the file format */
+ virtual void beginPath()=0;		// a path with the current pen
+ virtual void pathPoint(Point p, bool start)=0;	// start: of a subpath
+ virtual void endPath()=0;
+ virtual void finish()=0;		// end of the file
+	/* Write the path so far; needed before drawing anything else */
+ void flushPath();
+	/* Buffered output */
+ void put(const char*s);
+ void put(const char*s, size_t n);
+ void put(long v);
+ void put(double v);		// up to 3 decimals
+ size_t written() const {return count+buf.size();}
+ static int textWidth(const char*s);
+private:
+ FILE*f;
+ bool failed;
+ std::vector<char> buf;
+ size_t count;		// bytes written to f
+ double tol2;		// tolerance squared
+ Point cur;		// current position
+ std::vector<Point> pts;	// polyline not yet written, pts[0] already is if started
+ std::vector<unsigned char> keep;
+ std::vector<std::pair<size_t,size_t> > spans;
+ bool started;		// pts[0] was written
+ bool inPath;		// beginPath() was called
+ void endLine();		// write pts
+ void simplify();		// keep[i] for the points of pts to write
+ PlotVector(const PlotVector&);
+ void operator=(const PlotVector&);
+};
+
+class PlotSvg:public PlotVector{
+public:
+ PlotSvg(const char*path, int width, int height);
+ ~PlotSvg() {close();}
+ void erase(Color colour=WHITE);
+ void rectangle(int l, int t, int r, int b, Color fill=WHITE);
+ void text(int x, int y, const char*s, TextAlign align=LEFT, Color colour=BLACK);
+ void clip(int l, int t, int r, int b);
+ void unclip();
+protected:
+ void beginPath();
+ void pathPoint(Point p, bool start);
+ void endPath();
+ void finish();
+private:
+ int clips;		// clip paths so far
+ bool clipped;		// in a group of the last one
+ void colour(Color c);
+ void stroke();
+};
+
+class PlotPdf:public PlotVector{
+public:
+ PlotPdf(const char*path, int width, int height);
+ ~PlotPdf() {close();}
+ void erase(Color colour=WHITE);
+ void rectangle(int l, int t, int r, int b, Color fill=WHITE);
+ void text(int x, int y, const char*s, TextAlign align=LEFT, Color colour=BLACK);
+ void clip(int l, int t, int r, int b);
+ void unclip();
+protected:
+ void beginPath();
+ void pathPoint(Point p, bool start);
+ void endPath();
+ void finish();
+private:
+ bool clipped;		// in a saved graphics state with a clip path
+ size_t obj[7];		// file offsets of the objects
+ size_t streamStart;
+ void colour(Color c, const char*op);
+ void stroke();
+};
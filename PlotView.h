@@ -0,0 +1,111 @@
+/* File: PlotView.h
+ *
+ * Class Plotview
+ * Elements of data owned by someone else, read in place: a pointer to
+ * the first one, their number, and the distance in bytes from one to
+ * the next. So a field of an array of structures can be plotted, or
+ * used in expressions (PlotExpr.h), without copying it out.
+ *
+ * Example:
+ *		struct Sample{float_t t, volts; int flags;};
+ *		Sample s[1000];
+ *		Plotview t(&s[0].t, 1000, sizeof(Sample));
+ *		Plotview v(&s[0].volts, 1000, sizeof(Sample));
+ *		ps.addplot(t, v);
+ *
+ * The elements are float, double, int16_t or int32_t. Those that are not
+ * float_t are converted as they are read, a block at a time, after
+ * scaling: value = raw * gain + offset. The smallest integer of a type
+ * stands for NOPLOT (see PlotSamples.h).
+ * A view of a Plotchunks (PlotChunks.h) reads its chunks from the file.
+ * A view does not own the elements: they must outlive it, and whatever
+ * holds the view (such as a Plotstream trace).
+ * A Plotdata converts to a view of its elements as they are now.
+ *
+ * This file is included by PlotData.h and is not meant to be used alone.
+ */
+#pragma once
+
+#include <stdint.h>
+
+template<class T> class Plotsamples;
+class Plotchunks;
+
+// Element types of views, and the NOPLOT of each
+template<class T> struct PlotElement;
+template<> struct PlotElement<float>{enum{type=0}; static float none() {return NOPLOT;}};
+template<> struct PlotElement<double>{enum{type=1}; static double none() {return NOPLOT;}};
+template<> struct PlotElement<int16_t>{enum{type=2}; static int16_t none() {return numeric_limits<int16_t>::min();}};
+template<> struct PlotElement<int32_t>{enum{type=3}; static int32_t none() {return numeric_limits<int32_t>::min();}};
+
+class Plotview:public PlotExpr<Plotview>{
+public:
+ enum Type{FLOAT32, FLOAT64, INT16, INT32, CHUNKS};	// as PlotElement<>::type
+ Plotview():p(0),n(0),step(sizeof(float_t)),kind(Type(PlotElement<float_t>::type)),
+  gain(1),offset(0),native(true) {}
+	/* count elements from first, stride bytes apart, times gain plus offset */
+ template<class T> Plotview(const T*first, size_t count, size_t stride=sizeof(T),
+  float_t g=1, float_t o=0)
+ :p(first),n(count),step(stride),kind(Type(PlotElement<T>::type)),gain(g),offset(o),
+  native(kind==Type(PlotElement<float_t>::type) && g==1 && o==0) {}
+ Plotview(const Plotdata&d):p(d.begin()),n(d.size()),step(sizeof(float_t)),
+  kind(Type(PlotElement<float_t>::type)),gain(1),offset(0),native(true) {}
+ template<class T> Plotview(const Plotsamples<T>&s);	// PlotSamples.h
+ Plotview(const Plotchunks&c);				// PlotChunks.h
+
+ size_t size() const {return n;}
+	// first element, as float_t if isNative()
+ const float_t*data() const {return (const float_t*)p;}
+ size_t stride() const {return step;}
+ Type type() const {return kind;}
+	// float_t elements as they are
+ bool isNative() const {return native;}
+ bool contiguous() const {return native && step==sizeof(float_t);}
+	// the data read in chunks, if the view is of one
+ const Plotchunks*chunks() const {return kind==CHUNKS ? (const Plotchunks*)p : 0;}
+ float_t operator[](size_t i) const {
+  const char*q=(const char*)p+i*step;
+  return native ? *(const float_t*)q : kind==CHUNKS ? chunkAt(i) : convert(q);
+ }
+	// Elements i0..i0+m-1, gathered into buf unless contiguous (PlotExpr.h)
+ const float_t*block(size_t i0, size_t m, float_t*buf) const {
+  if (contiguous()) return (const float_t*)p+i0;
+  const char*q=(const char*)p+i0*step;
+  if (native) for (size_t i=0; i<m; i++, q+=step) buf[i]=*(const float_t*)q;
+  else switch (kind) {
+   case FLOAT32: scale((const float*)0,q,m,buf); break;
+   case FLOAT64: scale((const double*)0,q,m,buf); break;
+   case INT16: scale((const int16_t*)0,q,m,buf); break;
+   case INT32: scale((const int32_t*)0,q,m,buf); break;
+   case CHUNKS: return chunkBlock(i0,m,buf);
+  }
+  return buf;
+ }
+private:
+ const void*p;
+ size_t n;
+ size_t step;		// bytes
+ Type kind;
+ float_t gain,offset;
+ bool native;
+ float_t chunkAt(size_t i) const;			// PlotChunks.h
+ const float_t*chunkBlock(size_t i0, size_t m, float_t*buf) const;
+ template<class T> static float_t value(T v, float_t g, float_t o) {
+  return v==PlotElement<T>::none() ? NOPLOT : float_t(v)*g+o;	// NaN for floats anyway
+ }
+ float_t convert(const char*q) const {
+  switch (kind) {
+   case FLOAT32: return value(*(const float*)q,gain,offset);
+   case FLOAT64: return value(*(const double*)q,gain,offset);
+   case INT16: return value(*(const int16_t*)q,gain,offset);
+   default: return value(*(const int32_t*)q,gain,offset);
+  }
+ }
+	// a loop per type, which the compiler can vectorize when contiguous
+ template<class T> void scale(const T*, const char*q, size_t m, float_t*buf) const {
+  if (step==sizeof(T)) {
+   const T*s=(const T*)q;
+   for (size_t i=0; i<m; i++) buf[i]=value(s[i],gain,offset);
+  }else for (size_t i=0; i<m; i++, q+=step) buf[i]=value(*(const T*)q,gain,offset);
+ }
+};
@@ -13,18 +13,34 @@
  * Version:	1.2
  * Date:	January 2006
  */
-#include <ostream>
-#include <iomanip>
-#include <string>
+#include <cstdio>
+#include <cstdlib>
 #include <cfloat>
+#include <cctype>
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus>=201703L
+#include <charconv>
+#endif
+#endif
 
 #include "Plotstream.h"
-#include <sstream>
+#include "PlotImage.h"
+#include "PlotVector.h"
 //#include "BGI_util.h"
-#include <windowsx.h>
+
+#ifdef _WIN32
+#include "PlotGdi.h"
 
 HWND Plotstream::wnd;
 HDC Plotstream::dc;
+#else
+// a*b/c rounded, as the Windows function
+static int MulDiv(int a, int b, int c) {
+ long long p=(long long)a*b;
+ return int((p<0)==(c<0) ? (p+c/2)/c : (p-c/2)/c);
+}
+#endif
 
 
 // Constants used exclusively in this file
@@ -45,22 +61,54 @@ static const float_t epsilon		= DBL_EPSILON * 1000; // Extremely small differenc
 
 // Mouse events variables used exclusively in this file
 //static bool left_clicked = false;
+#ifdef _WIN32
 static int cursorX;
 static int cursorY;
+#endif
 
-// dtoa safely converts a double to the equivalent char *
-// It is the responsibility of the calling program to delete the returned string
-static char * dtoa(float_t val)
-{
-	ostringstream ostr;
-	ostr.precision(3);
-	ostr << val;
+/* Write v into s as printf("%.*e") (scientific) or printf("%.*g") does,
+ * with std::to_chars when the library has it (C++17), which does not
+ * depend on the locale. Nothing is allocated and nothing is shared,
+ * so threads may format at once. 32 bytes hold any precision up to 17.
+ * @return the length, s is 0-terminated
+ */
+static int format(char*s, size_t size, double v, bool scientific, int precision) {
+#if defined(__cpp_lib_to_chars)
+ std::to_chars_result r=std::to_chars(s,s+size-1,v,
+   scientific ? std::chars_format::scientific : std::chars_format::general,precision);
+ if (r.ec==std::errc()) {
+  *r.ptr=0;
+  return int(r.ptr-s);
+ }
+#endif
+ int n=snprintf(s,size,scientific ? "%.*e" : "%.*g",precision,v);
+ if (n<0) n=0;
+ else if (size_t(n)>=size) n=int(size-1);
+ return n;
+}
 
-	char * ret = new char[ostr.str().size() + 1];
-	strcpy(ret, ostr.str().c_str());
-	return ret;
+/* Tick label of val into s, 3 significant digits, as "%.3g" */
+static const char*label(char*s, size_t size, float_t val) {
+ format(s,size,val,false,3);
+ return s;
 }
 
+/* The first n significant digits of val (n<=9) as an integer, and the
+ * position of the decimal point relative to them, as _ecvt() gives.
+ */
+static int significant(float_t val, int n, int&decPos, bool&neg) {
+ char s[32];
+ format(s,sizeof s,val,true,n-1);
+ const char*p=s;
+ neg=*p=='-';
+ if (neg) p++;
+ decPos=0;
+ if (!isdigit((unsigned char)*p)) return 0;	// inf or nan
+ int digits=0;
+ for (; *p && *p!='e'; p++) if (isdigit((unsigned char)*p)) digits=digits*10+(*p-'0');
+ if (*p) decPos=int(strtol(p+1,0,10))+1;
+ return digits;
+}
 
 // pow10() does not exist in mingw (redefine as inline wrapper here)
 static inline float_t pow10(float_t x) {return pow(10.0,x);}
@@ -73,11 +121,10 @@ static inline float_t pow10(float_t x) {return pow(10.0,x);}
  * @return		truncated value as a double (may be inexact)
  */
 static float_t floatRound(float_t val, int&sigDigits, int&intrep) {
- int neg;
+ bool neg;
  int decPos;
  const int n=2;	// wanted significant digits
- char*str=_ecvt(val,n,&decPos,&neg);
- intrep = atoi(str);
+ intrep=significant(val,n,decPos,neg);
  sigDigits=n;
 	// find position of dot if any
  if (decPos>=n) { // then it's an integer, return now
@@ -109,6 +156,20 @@ static void getNearest(Plotdata::Range&range) {
             floatRound(range.max + dif / 2, sigdigits, intrep));
 }
 
+/* Local function hidden at file scope
+ * Grow a range shown on the axes so that it covers the data range,
+ * plus a quarter of that on the sides where it was too small, so that
+ * a growing trace does not change the axes at every new point.
+ * @return true if the range changed
+ */
+static bool cover(Plotdata::Range&shown, const Plotdata::Range&data) {
+ float_t more=(data.max-data.min)/4;
+ bool r=false;
+ if (data.min<shown.min) {shown.min=data.min-more; r=true;}
+ if (data.max>shown.max) {shown.max=data.max+more; r=true;}
+ return r;
+}
+
 /*
  * Local function hidden at file scope
  * Attempt to guess a convenient divisor for grid along the X axis
@@ -262,7 +323,9 @@ static void delRectangle(int x1, int y1, int x2, int y2)
 /************************* CLASS FUNCTIONS ***************************/
 
 Plotstream::Plotstream(const char*title)
-:plotStarted(false) {
+:canvas(0),plotStarted(false),decimating(true),pyramids(false),viewing(false),incrementing(false),
+ painted(false),paintedOn(0),paintedWidth(0),paintedHeight(0) {
+#ifdef _WIN32
  if (!wnd) wnd=CreateWindow("koolplot",title,WS_OVERLAPPEDWINDOW|WS_VISIBLE,
    CW_USEDEFAULT,CW_USEDEFAULT,CW_USEDEFAULT,CW_USEDEFAULT,
    0,0,0,this);
@@ -270,22 +333,81 @@ Plotstream::Plotstream(const char*title)
   SetWindowLongPtr(wnd,0,(LONG_PTR)this);	// repoint Windows object data
   if (title) SetWindowText(wnd,title);
  }
+#else
+ (void)title;
+#endif
 }
 
 void Plotstream::addplot(const Plotdata&x, const Plotdata&y, Color color) {
+ addplot(Plotview(),Plotview(),color);
+ xytrace&t=traces.back().t;
+ t.x=&x;
+ t.y=&y;
+}
+
+void Plotstream::addplot(const Plotview&x, const Plotview&y, Color color) {
  size_t i=traces.size();
  traces.resize(i+1);
  internal_xytrace&t=traces[i];
- t.t.x=&x;
- t.t.y=&y;
+ t.t.x=0;
+ t.t.y=0;
+ t.t.vx=x;
+ t.t.vy=y;
  t.t.a.colour=color;
  t.t.a.drawstyle=0;
- t.t.a.penstyle=PS_SOLID;
+ t.t.a.penstyle=PlotCanvas::SOLID;
  t.t.a.penwidth=1;
- t.g.penPlot=CreatePen(t.t.a.penstyle,t.t.a.penwidth,t.t.a.colour);
+ t.drawn=0;
+ t.col.n=0;
+ t.checked=0;
+ painted=false;
+}
+
+void Plotstream::pyramid(bool on) {
+ pyramids=on;
+ for (auto t=traces.begin(); t!=traces.end(); t++) t->lod.reset();
+ painted=false;
+}
+
+void Plotstream::view(float_t x0, float_t x1, float_t y0, float_t y1) {
+	// as long as float_t can tell the pixels apart
+ const float_t tiny=256*numeric_limits<float_t>::epsilon();
+ if (!(x1-x0>tiny*max(fabs(x0),fabs(x1))) || !(y1-y0>tiny*max(fabs(y0),fabs(y1)))
+  || !isfinite(x1-x0) || !isfinite(y1-y0)) return;
+ viewX.init(x0,x1);
+ viewY.init(y0,y1);
+ viewing=true;
+ painted=false;
+}
+
+void Plotstream::zoom(float_t factor, int x, int y) {
+ if (!paintedWidth || rcPlot.width()<1 || rcPlot.height()<1 || !(factor>0)) return;
+ Plotdata::Range vx=viewing ? viewX : xr, vy=viewing ? viewY : yr;
+ float_t cx=vx.min+vx.delta()*(x-rcPlot.left)/rcPlot.width();
+ float_t cy=vy.min+vy.delta()*(rcPlot.bottom-y)/rcPlot.height();
+ view(cx-(cx-vx.min)/factor,cx+(vx.max-cx)/factor,cy-(cy-vy.min)/factor,cy+(vy.max-cy)/factor);
+}
+
+void Plotstream::pan(int dx, int dy) {
+ if (!paintedWidth || rcPlot.width()<1 || rcPlot.height()<1) return;
+ Plotdata::Range vx=viewing ? viewX : xr, vy=viewing ? viewY : yr;
+ float_t sx=vx.delta()*dx/rcPlot.width(), sy=vy.delta()*dy/rcPlot.height();
+ view(vx.min-sx,vx.max-sx,vy.min+sy,vy.max+sy);
+}
+
+void Plotstream::zoomBox(int x0, int y0, int x1, int y1) {
+ if (!paintedWidth || rcPlot.width()<1 || rcPlot.height()<1) return;
+ if (x1<x0) swap(x0,x1);
+ if (y1<y0) swap(y0,y1);
+ if (x1-x0<2 || y1-y0<2) return;	// a click, not a box
+ Plotdata::Range vx=viewing ? viewX : xr, vy=viewing ? viewY : yr;
+ float_t sx=vx.delta()/rcPlot.width(), sy=vy.delta()/rcPlot.height();
+ view(vx.min+(x0-rcPlot.left)*sx,vx.min+(x1-rcPlot.left)*sx,
+  vy.min+(rcPlot.bottom-y1)*sy,vy.min+(rcPlot.bottom-y0)*sy);
 }
 
 void Plotstream::show(const char*title) {
+#ifdef _WIN32
  if (title) SetWindowText(wnd,title);
  InvalidateRect(wnd,0,TRUE);
  MSG Msg;
@@ -293,6 +415,9 @@ void Plotstream::show(const char*title) {
   TranslateMessage(&Msg);
   DispatchMessage(&Msg);
  }
+#else
+ (void)title;
+#endif
 }
 
 void Plotstream::plot(const Plotdata&x, const Plotdata&y, Color color) {
@@ -303,46 +428,169 @@ void Plotstream::plot(const Plotdata&x, const Plotdata&y, Color color) {
 Plotstream::~Plotstream() {
  //std::vector<internal_xytrace>::iterator t;
  for (auto t=traces.begin(); t!=traces.end(); t++) {
-  DeleteObject(t->g.penPlot);
   t->markers.clear();
  }
  traces.clear();
 }
 
+#ifdef _WIN32
+// Draw off-screen, then copy the whole frame at once
 void Plotstream::onPaint() {
- RECT r;
- GetClientRect(wnd,&r);
+ PlotGdi win(dc,wnd);
+ paint(buffer(win));
+ win.copy(*frame);
+}
+
+void Plotstream::update() {
+ HDC wdc=GetDC(wnd);
+ {
+  PlotGdi win(wdc,wnd);
+  update(buffer(win));
+  win.copy(*frame);
+ }
+ ReleaseDC(wnd,wdc);
+}
+
+PlotCanvas&Plotstream::buffer(PlotCanvas&win) {
+ if (!frame || frame->width()!=win.width() || frame->height()!=win.height())
+  frame.reset(win.layer());
+ return *frame;
+}
+#endif
+
+static const size_t lodPoints=size_t(1)<<20;	// smallest trace drawn from a PlotLod
+static const float_t guard=1<<16;		// pixels around the view where lines are cut
+static const float_t pixelMax=1<<30;	// beyond, screen coordinates are clamped
+
+// Screen coordinate, within int, of a value scaled in pixels
+static inline int pixel(float_t v) {return v<-pixelMax ? -int(pixelMax) : v>pixelMax ? int(pixelMax) : int(v);}
+
+// A ring moves its points as it goes (Plotdata::ring())
+static bool isRing(const Plotstream::xytrace&t) {
+ return (t.x && t.x->capacity()) || (t.y && t.y->capacity());
+}
+
+bool Plotstream::dataRange(Plotdata::Range&xd, Plotdata::Range&yd) const{
+ bool r=false;
  //internal_xytrace*t;
 
  for (auto t=traces.begin(); t!=traces.end(); t++) {
 	// Need 2 points minimum to do a plot
-  if (t->t.x->size() < 2) break;
+  Plotview x=t->t.xview(), y=t->t.yview();
+  if (x.size() < 2) break;
 	// Need as many y values as x values to do a plot
-  if (t->t.x->size() > t->t.y->size()) break;
+  if (x.size() > y.size()) break;
 	// Store the hi and lo points of the axes
-  Plotdata::rangeXY(*t->t.x,*t->t.y,xr,yr);
+  size_t n=min(x.size(),y.size());
+  const PlotLod*lod=pyramids && decimating && !isRing(t->t) ? t->lod.get() : 0;
+	// from the levels of detail, unless many points were added since
+  if (lod && lod->size() && lod->size()<=n && n-lod->size()<lodPoints) lod->range(x,y,n,xd,yd);
+  else if (t->t.x && t->t.y) Plotdata::rangeXY(*t->t.x,*t->t.y,xd,yd);	// cached
+  else Plotdata::rangeXY(x,y,xd,yd);
 //  Plotdata::maxXY(*t->t.x,*t->t.y,hi_x,hi_y);
+  r=true;
  }
+ return r;
+}
+
+void Plotstream::paint(PlotCanvas&c) {
+ canvas=&c;
+ if (viewing) {
+  xr=viewX;
+  yr=viewY;
+ }else if (!incrementing || !painted) {
+  dataRange(xr,yr);
     // Set Y values to the nearest "round" numbers
- getNearest(yr);
+  getNearest(yr);
+ }else{
+  Plotdata::Range xd, yd;
+  if (dataRange(xd,yd)) {
+   cover(xr,xd);
+   if (cover(yr,yd)) getNearest(yr);
+  }
+ }
 
  x_range = xr.delta();
  y_range = -yr.delta();	// negative!
 
- SetRect(&rcPlot,left_border,border_height,r.right-border_width,r.bottom-border_height);
+ rcPlot.set(left_border,border_height,c.width()-border_width,c.height()-border_height);
 
  x_scale = x_range / (rcPlot.right-rcPlot.left);
  y_scale = y_range / (rcPlot.bottom-rcPlot.top);
 
- drawAxes();
+ if (!copyAxes(c)) drawAxes();
 
+ if (viewing) {
+  float_t gx=guard*x_scale, gy=-guard*y_scale;
+  guardX.init(xr.min-gx,xr.max+gx);
+  guardY.init(yr.min-gy,yr.max+gy);
+  c.clip(rcPlot.left,rcPlot.top,rcPlot.right+1,rcPlot.bottom+1);
+ }
  for (auto t=traces.begin(); t!=traces.end(); t++) drawFunc(*t);
+ if (viewing) c.unclip();
+ canvas=0;
+ painted=true;
+ paintedOn=&c;
+ paintedWidth=c.width();
+ paintedHeight=c.height();
+}
+
+bool Plotstream::update(PlotCanvas&c) {
+ bool all=viewing || !painted || &c!=paintedOn || c.width()!=paintedWidth || c.height()!=paintedHeight;
+ for (auto t=traces.begin(); t!=traces.end() && !all; t++) {
+	// a ring moves its points, a shorter trace lost some
+  if (isRing(t->t) || min(t->t.xview().size(),t->t.yview().size())<t->drawn) painted=false;
+  all=!painted;
+ }
+ Plotdata::Range xd, yd;
+ if (!all && dataRange(xd,yd))
+  all=xd.min<xr.min || xd.max>xr.max || yd.min<yr.min || yd.max>yr.max;
+ if (all) {
+  c.erase();
+  paint(c);
+  return true;
+ }
+ canvas=&c;
+ for (auto t=traces.begin(); t!=traces.end(); t++) {
+  canvas->pen(t->t.a.colour,t->t.a.penwidth,PlotCanvas::PenStyle(t->t.a.penstyle));
+  drawNew(*t);
+ }
+ canvas=0;
+ return false;
+}
+
+// path ends in .ext, any case
+static bool extension(const char*path, const char*ext) {
+ const char*dot=strrchr(path,'.');
+ if (!dot) return false;
+ for (dot++; *dot && tolower((unsigned char)*dot)==*ext; dot++, ext++);
+ return !*dot && !*ext;
+}
+
+bool Plotstream::saveImage(const char*path, int width, int height) {
+ if (width<=0 || height<=0) return false;
+ if (extension(path,"svg")) {
+  PlotSvg svg(path,width,height);
+  if (!svg.ok()) return false;
+  paint(svg);
+  return svg.close();
+ }
+ if (extension(path,"pdf")) {
+  PlotPdf pdf(path,width,height);
+  if (!pdf.ok()) return false;
+  paint(pdf);
+  return pdf.close();
+ }
+ static thread_local PlotRaster img(0,0);	// pixels kept for the next image
+ img.resize(width,height);
+ paint(img);
+ return plotSaveImage(img,path);
 }
 
 /* Convert graph x value to screen coordinate */
-int Plotstream::X(float_t x) const{ return int((x - xr.min) / x_scale + rcPlot.left);}
+int Plotstream::X(float_t x) const{ return pixel((x - xr.min) / x_scale + rcPlot.left);}
 /* Convert graph y value to screen coordinate */
-int Plotstream::Y(float_t y) const{ return int((y - yr.max) / y_scale + rcPlot.top);}
+int Plotstream::Y(float_t y) const{ return pixel((y - yr.max) / y_scale + rcPlot.top);}
 
 /* Convert screen coordinate to graph x value */
 float_t Plotstream::plotX(int screenX) const{ return (screenX - rcPlot.left) * x_scale + xr.min;}
@@ -561,6 +809,25 @@ Rounding Plotstream::nearRoundY(float_t & val, Rounding direction) const
 	}
 }
 
+/* The axes only change with the size of the canvas and the ranges:
+ * they are drawn on a layer of the canvas (PlotCanvas.h), kept, and
+ * copied onto the canvas at the next paints, until one of these
+ * changes. Then the traces are drawn over them.
+ * @return false if c has no layers; the axes must be drawn on it
+ */
+bool Plotstream::copyAxes(PlotCanvas&c) {
+ if (axes && axesX.min==xr.min && axesX.max==xr.max
+  && axesY.min==yr.min && axesY.max==yr.max && c.copy(*axes)) return true;
+ axes.reset(c.layer());
+ if (!axes) return false;
+ axesX=xr;
+ axesY=yr;
+ canvas=axes.get();
+ drawAxes();
+ canvas=&c;
+ return c.copy(*axes);
+}
+
 /* Draw the axes */
 void Plotstream::drawAxes() {
  int xDivs;				// number of x divisions
@@ -569,11 +836,8 @@ void Plotstream::drawAxes() {
  int sigdigits;
  int intVal;
 	// draw the rectangle
- HPEN penRect=CreatePen(PS_SOLID,1,DARKGRAY);
- HPEN penGrid=CreatePen(PS_DOT,0,LIGHTGRAY);
- HPEN penMark=CreatePen(PS_SOLID,0,DARKGRAY);
- HPEN open=SelectPen(dc,penRect);
- Rectangle(dc,rcPlot.left-1,   // -1 to fix small discrepancy on screen
+ canvas->pen(DARKGRAY);
+ canvas->rectangle(rcPlot.left-1,   // -1 to fix small discrepancy on screen
 		rcPlot.top-1, // Probably due to line width.
 		rcPlot.right,
 		rcPlot.bottom);
@@ -585,7 +849,7 @@ void Plotstream::drawAxes() {
  else*/ yDivs = getYDivisor(yr.min,yr.max, rcPlot.bottom-rcPlot.top);
 
 	// draw the grid
- SelectPen(dc,penGrid);
+ canvas->pen(LIGHTGRAY,1,PlotCanvas::DOT);
  int i;
 	// Horizontal grid
  for (i = yDivs - 1; i > 0; i--) {
@@ -600,7 +864,7 @@ void Plotstream::drawAxes() {
   lineto(x,rcPlot.bottom);
  }
 	// Draw Axes markers
- SelectPen(dc,penMark);
+ canvas->pen(DARKGRAY);
 	// Y axis
  for (i = yDivs - 1; i > 0; i--) {
   int y=rcPlot.top + MulDiv(rcPlot.height(),i,yDivs);
@@ -618,14 +882,10 @@ void Plotstream::drawAxes() {
   lineto(x,rcPlot.top+mark_length);
  }
 	// Number the axes
- SetTextColor(dc,BLACK);
- SetBkMode(dc,TRANSPARENT);
 	// Y axis
- HFONT fntY=CreateFont(16,0,0,0,0,0,0,0,0,0,0,0,0,"Arial");
- HFONT ofnt=SelectFont(dc,fntY);
- SetTextAlign(dc,TA_RIGHT|TA_TOP);
- SIZE sz;
- GetTextExtentPoint32(dc,"0",1,&sz);
+ struct{int cx,cy;} sz;
+ char s[32];		// a label
+ canvas->textSize("0",sz.cx,sz.cy);
 // divLength = int(rcPlot.height() / yDivs);
  float_t divVal = floatRound(-yr.delta() / yDivs, sigdigits, intVal);
 
@@ -633,66 +893,264 @@ void Plotstream::drawAxes() {
   int y=rcPlot.top + MulDiv(rcPlot.height(),i,yDivs)-sz.cy/2;
   float_t val = floatRound(yr.max + divVal * i, sigdigits, intVal);
   if (fabs(val) < chouia * yr.delta()) val = 0;
-  char * asciival = dtoa(val);
-  outtextxy(rcPlot.left-sz.cx,y,asciival);
-  delete [] asciival;
+  canvas->text(rcPlot.left-sz.cx,y,label(s,sizeof s,val),PlotCanvas::RIGHT);
  }
 	// X axis
- SetTextAlign(dc,TA_CENTER|TA_TOP);
  divVal = floatRound(xr.delta() / xDivs, sigdigits, intVal);
  for (i = 0;  i <= xDivs; i++) {
   int x=rcPlot.left + MulDiv(rcPlot.width(),i,xDivs);
   float_t val = floatRound(xr.min + divVal * i, sigdigits, intVal);
   if (fabs(val) < chouia * xr.delta()) val = 0;
-  char * asciival = dtoa(val);
-  outtextxy(x,rcPlot.bottom+sz.cy/4, asciival);
-  delete[] asciival;
+  canvas->text(x,rcPlot.bottom+sz.cy/4,label(s,sizeof s,val),PlotCanvas::CENTER);
  }
- SelectFont(dc,ofnt);
- DeleteFont(fntY);
- SelectPen(dc,open);
- DeletePen(penMark);
- DeletePen(penGrid);
- DeletePen(penRect);
 }
 
+/* Draw a trace with one lineto per point, or, when decimating,
+ * with a handful per pixel column (M4 decimation):
+ * consecutive points that fall into the same column are joined by
+ * vertical segments, which cover every pixel between the lowest and
+ * the highest of them. Drawing only the first, lowest, highest and last
+ * point, in their original order, sets the same pixels, and segments
+ * to and from the neighbouring columns are unchanged.
+ * The line end pixel is not drawn; so that it stays drawn wherever the
+ * full trace had drawn it, the last point that differs from the end
+ * point is kept too when it comes after the lowest and highest.
+ * Hence the output is identical, for monotonic x and in fact for any x.
+ * Non-finite points (NOPLOT) still break the line.
+ * With pyramids, a large trace is drawn from its PlotLod first, which
+ * gives these points without reading the others (drawLod()).
+ */
 void Plotstream::drawFunc(internal_xytrace&t) {
- vector<float_t>::const_iterator x_it  = t.t.x->getData().begin();
- vector<float_t>::const_iterator y_it  = t.t.y->getData().begin();
- vector<float_t>::const_iterator x_end = t.t.x->getData().end();
+ canvas->pen(t.t.a.colour,t.t.a.penwidth,PlotCanvas::PenStyle(t.t.a.penstyle));
+ const Plotview x=t.t.xview();
+ size_t n=min(x.size(),t.t.yview().size()), i0=0, i1=n;
+ if (decimating && pyramids) levels(t);
+ if (viewing) visible(t,x,n,i0,i1);
+ t.drawn=i0;
+ t.col.n=0;
+ clipPrev=false;
+ if (decimating && pyramids && t.lod) drawLod(t,i1);
+ drawNew(t,i1);
+ //marker_t*marker;
+ for (auto marker=t.markers.begin(); marker!=t.markers.end(); marker++) {
+  drawPointShape(X(marker->x),Y(marker->y));
+ }
+}
 
- HPEN open=SelectPen(dc,t.g.penPlot);
+/* Go on from where drawing of the trace stopped: t.col is the column
+ * being drawn when decimating, else its x and first are the last point
+ * drawn; col.n is 0 when the line is broken. An unfinished column is
+ * drawn again from its first point, with the points added to it.
+ */
+void Plotstream::drawNew(internal_xytrace&t, size_t end) {
+ const Plotview x=t.t.xview(), y=t.t.yview();
+ size_t n=min(min(x.size(),y.size()),end);
+ column_t c=t.col;
 
- if (isfinite(*y_it) && isfinite(*x_it)) {
-  moveto(X(*x_it), Y(*y_it));
-  plotStarted = true;
+ plotStarted = c.n!=0;
+ if (plotStarted) moveto(c.x,c.first);
+ drawPoints(x,y,t.drawn,n,c);
+ if (decimating && c.n) drawColumn(c);
+ t.drawn=n;
+ t.col=c;
+}
+
+void Plotstream::drawPoints(const Plotview&x, const Plotview&y, size_t i0, size_t i1,
+ column_t&c) {
+ float_t bx[PLOT_BLOCK], by[PLOT_BLOCK];	// elements as float_t (PlotView.h)
+ for (; i0<i1; i0+=PLOT_BLOCK) {
+  size_t m=i1-i0<PLOT_BLOCK ? i1-i0 : PLOT_BLOCK;
+  const float_t*xs=x.block(i0,m,bx), *ys=y.block(i0,m,by);
+  for (size_t j=0; j<m; j++) addPoint(c,xs[j],ys[j]);
+ }
+}
+
+void Plotstream::plotPoint(column_t&c, float_t x, float_t y) {
+ if (isfinite(y) && isfinite(x)) {
+  plotto(c.x=X(x), c.first=Y(y));
+  c.n=1;
  }else{
-    // Else if both x and y are NAN, then it could be either a color change
-    // request or a single point drawing request.
-// if (!isfinite(*y_it) && !isfinite(*x_it)
-// && x_it+1 != x_end && x_it+2 != x_end) handleCommand(x_it, y_it);
- }
-
- while (++x_it != x_end) {
-  if (isfinite(*(++y_it)) && isfinite(*x_it)) {
-   if (plotStarted) lineto(X(*x_it), Y(*y_it));
-   else{
-    moveto(X(*x_it), Y(*y_it));
-    plotStarted = true;
+  plotStarted = false;
+  c.n=0;
+ }
+}
+
+void Plotstream::toColumn(column_t&c, float_t x, float_t y) {
+ if (!isfinite(x) || !isfinite(y)) {
+  if (c.n) drawColumn(c);
+  c.n=0;
+  plotStarted = false;
+  return;
+ }
+ int px=X(x), py=Y(y);
+ if (c.n && px==c.x) {
+  if (py<c.lo) {c.lo=py; c.ilo=c.n;}
+  if (py>c.hi) {c.hi=py; c.ihi=c.n;}
+  if (py!=c.last) {c.back=c.last; c.iback=c.n-1;}
+  c.last=py;
+  c.n++;
+ }else{
+  if (c.n) drawColumn(c);
+  plotto(px,py);
+  c.x=px;
+  c.first=c.last=c.lo=c.hi=c.back=py;
+  c.n=1;
+  c.ilo=c.ihi=c.iback=0;
+ }
+}
+
+// Cut [t0,t1] of a segment where p + t*q >= 0 stops holding (Liang-Barsky)
+static bool clipEdge(double q, double p, double&t0, double&t1) {
+ if (q==0) return p>=0;
+ double t=-p/q;
+ if (q>0) {if (t>t0) t0=t;}
+ else if (t<t1) t1=t;
+ return t0<=t1;
+}
+
+/* While zoomed, points far from the view would overflow screen
+ * coordinates, and lines to them would go astray: each segment is cut
+ * to its part within the guard box, far enough around the view that the
+ * cut moves nothing on screen. The line is broken where it leaves the box,
+ * and starts again where it comes back.
+ */
+void Plotstream::clipPoint(column_t&c, float_t x, float_t y) {
+ double x0=clipX, y0=clipY;
+ bool from=clipPrev;
+ clipPrev=isfinite(x) && isfinite(y);
+ clipX=x;
+ clipY=y;
+ if (!clipPrev) {drawPoint(c,x,y); return;}	// breaks the line
+ bool in=x>=guardX.min && x<=guardX.max && y>=guardY.min && y<=guardY.max;
+ if (!from) {
+  if (in) drawPoint(c,x,y);
+  return;
+ }
+ double dx=x-x0, dy=y-y0, t0=0, t1=1;
+ if (!clipEdge(dx,x0-guardX.min,t0,t1) || !clipEdge(-dx,guardX.max-x0,t0,t1)
+  || !clipEdge(dy,y0-guardY.min,t0,t1) || !clipEdge(-dy,guardY.max-y0,t0,t1)) return;
+ if (t0>0) drawPoint(c,float_t(x0+t0*dx),float_t(y0+t0*dy));	// comes in
+ if (t1<1) {					// goes out
+  drawPoint(c,float_t(x0+t1*dx),float_t(y0+t1*dy));
+  drawPoint(c,NOPLOT,NOPLOT);
+ }else drawPoint(c,x,y);
+}
+
+/* A ring moves its points, so its PlotLod would not stay valid */
+void Plotstream::levels(internal_xytrace&t) {
+ const Plotview x=t.t.xview(), y=t.t.yview();
+ size_t n=min(x.size(),y.size());
+ if (n<lodPoints || isRing(t.t)) {
+  t.lod.reset();
+  return;
+ }
+ if (!t.lod) t.lod.reset(new PlotLod);
+ if (t.lod->size()>n || n>=2*t.lod->size()) t.lod->build(x,y);
+}
+
+/* Draw the trace from t.drawn up to the last block of its PlotLod before
+ * end, from the largest blocks that line up with their size, then from
+ * their halves where they cross pixel columns, down to the points of
+ * level 0 blocks. The column is left unfinished for drawNew() to go on.
+ */
+void Plotstream::drawLod(internal_xytrace&t, size_t end) {
+ const Plotview x=t.t.xview(), y=t.t.yview();
+ const PlotLod&lod=*t.lod;
+ size_t j=(t.drawn+PlotLod::base-1)/PlotLod::base;	// blocks of level 0
+ size_t m=min(end,lod.size())/PlotLod::base;
+ if (j>=m) return;
+ column_t c=t.col;
+ plotStarted = c.n!=0;
+ drawPoints(x,y,t.drawn,j*PlotLod::base,c);
+ while (j<m) {
+  unsigned k=lod.top(j,m);
+  drawBlock(lod,x,y,k,j>>k,c);
+  j+=size_t(1)<<k;
+ }
+ t.drawn=m*PlotLod::base;
+ t.col=c;
+}
+
+void Plotstream::drawBlock(const PlotLod&lod, const Plotview&x, const Plotview&y,
+ unsigned k, size_t j, column_t&c) {
+ const PlotLod::Entry&e=lod.entry(k,j);
+ if (!e.broken && X(e.xmin)==X(e.xmax)) {	// what decimation would keep
+  addPoint(c,e.xmin,e.first);
+  addPoint(c,e.xmin,e.minFirst ? e.ymin : e.ymax);
+  addPoint(c,e.xmin,e.minFirst ? e.ymax : e.ymin);
+  addPoint(c,e.xmin,e.last);
+ }else if (k) {
+  drawBlock(lod,x,y,k-1,2*j,c);
+  drawBlock(lod,x,y,k-1,2*j+1,c);
+ }else drawPoints(x,y,j*PlotLod::base,(j+1)*PlotLod::base,c);
+}
+
+/* Sorted means finite and never decreasing. The points checked are not
+ * checked again, unless the trace got shorter; its PlotLod tells for
+ * those it summarizes.
+ */
+bool Plotstream::sortedX(internal_xytrace&t, const Plotview&x, size_t n) {
+ if (isRing(t.t)) return false;
+ if (n<t.checked) t.checked=0;
+ if (!t.checked) t.sorted=true;
+ if (t.lod && t.lod->size()>t.checked && t.lod->size()<=n) {
+  t.sorted=t.lod->sorted();
+  t.checked=t.lod->size();
+ }
+ if (t.sorted && n>t.checked) {
+  size_t i0=t.checked ? t.checked-1 : 0;	// pairs i, i+1 from i0 on
+  size_t pairs=n-1-i0;
+  if (!t.checked && !isfinite(x[0])) t.sorted=false;
+  unsigned parts=plotParts(pairs,1<<16);
+  vector<char> ok(parts,1);
+  plotParallel(parts,pairs,[&](unsigned k,size_t a,size_t b){
+   float_t buf[PLOT_BLOCK+1];
+   for (size_t i=i0+a; i<i0+b && ok[k]; i+=PLOT_BLOCK) {
+    size_t m=i0+b-i<PLOT_BLOCK ? i0+b-i : PLOT_BLOCK;
+    const float_t*p=x.block(i,m+1,buf);
+    for (size_t j=0; j<m; j++) if (!(p[j+1]>=p[j]) || !isfinite(p[j+1])) {ok[k]=0; break;}
    }
-  }else{
-   plotStarted = false;
-            // If both x and y are NAN, then it could be either a colour
-            // change request or a single point drawing request.
-//   if (!isfinite(*y_it) && !isfinite(*x_it)
-//   && x_it+1 != x_end && x_it+2 != x_end) handleCommand(x_it, y_it);
-  }
+  });
+  for (unsigned k=0; k<parts; k++) if (!ok[k]) t.sorted=false;
  }
- //marker_t*marker;
- for (auto marker=t.markers.begin(); marker!=t.markers.end(); marker++) {
-  drawPointShape(X(marker->x),Y(marker->y));
+ t.checked=n;
+ return t.sorted;
+}
+
+/* Those within the x range of the view, when x is sorted, found by
+ * bisection; else all of them. The range is a pixel wider on each side,
+ * so that the columns at the edges get all their points, and one more
+ * point on each side gives the lines coming in.
+ */
+void Plotstream::visible(internal_xytrace&t, const Plotview&x, size_t n, size_t&i0, size_t&i1) {
+ if (n<2 || !sortedX(t,x,n)) return;
+ float_t lo=xr.min-x_scale, hi=xr.max+x_scale;
+ size_t a=0, b=n;
+ while (a<b) {size_t m=a+(b-a)/2; if (x[m]<lo) a=m+1; else b=m;}
+ i0=a ? a-1 : 0;
+ b=n;
+ while (a<b) {size_t m=a+(b-a)/2; if (x[m]<=hi) a=m+1; else b=m;}
+ i1=a<n ? a+1 : n;
+}
+
+void Plotstream::plotto(int x, int y) {
+ if (plotStarted) lineto(x,y);
+ else{
+  moveto(x,y);
+  plotStarted = true;
+ }
+}
+
+void Plotstream::drawColumn(const column_t&c) const{
+	// lo, hi and back sorted by index, then the last point
+ struct{size_t i; int y;} p[4]={{c.ilo,c.lo},{c.ihi,c.hi},{c.iback,c.back},{c.n-1,c.last}};
+ for (int k=1; k<3; k++) for (int j=k; j && p[j].i<p[j-1].i; j--) swap(p[j],p[j-1]);
+ size_t i=0;
+ int y=c.first;	// already drawn
+ for (int k=0; k<4; k++) if (p[k].i>i) {
+  if (p[k].y!=y) lineto(c.x,y=p[k].y);
+  i=p[k].i;
  }
- SelectPen(dc,open);
 }
 
 // draws the marker shape in X and Y.
@@ -4,19 +4,30 @@
  * A plotstream opens a window, displays a data plot, then closes
  * the window when the user presses a key.
  *
+ * All drawing goes through a PlotCanvas: the window's device context
+ * on Windows, or any canvas passed to paint(), such as a PlotRaster
+ * image. Without Windows there is no window, and paint() is the only
+ * way to get the plot.
+ *
  * Author: 	jlk
  * Version:	1.1
  * Date:	July 2005
  */
 #pragma once
 
+#include <cstring>
+
 #include "PlotData.h"
+#include "PlotCanvas.h"
+#include "PlotLod.h"
 
 enum Rounding{DOWN,ANY,UP};
 
-struct Rect:public RECT{
- LONG width() const{return right-left;}
- LONG height() const{return bottom-top;}
+struct Rect{
+ int left,top,right,bottom;
+ void set(int l, int t, int r, int b) {left=l; top=t; right=r; bottom=b;}
+ int width() const{return right-left;}
+ int height() const{return bottom-top;}
 };
 
 class Plotstream{
@@ -25,11 +36,64 @@ public:
  Plotstream(const char*title=0);
  ~Plotstream();
  void addplot(const Plotdata&x, const Plotdata&y, Color colour = GREEN);
+	// Plot data in place, without copying (PlotView.h); the data must
+	// stay until the Plotstream is done with it. With a Plotdata and a
+	// view, write Plotview(data).
+ void addplot(const Plotview&x, const Plotview&y, Color colour = GREEN);
+	// Plot compact data in place (PlotSamples.h), with the same care
+ template<class T, class U> void addplot(const Plotsamples<T>&x, const Plotsamples<U>&y,
+  Color colour = GREEN) {addplot(x.view(),y.view(),colour);}
  void show(const char*title=0);
  void plot(const Plotdata&x, const Plotdata&y, Color colour = GREEN);
+	// Draw only first/lowest/highest/last point of each pixel column
+	// (on by default, gives the same pixels as drawing every point)
+ void decimate(bool on) {decimating=on; painted=false;}
+	// Also draw traces of a million points or more from levels of
+	// detail (PlotLod.h), built at their first paint and again when they
+	// have doubled, in time proportional to the width rather than to the
+	// points. Change traces only by adding points, or turn this on again.
+ void pyramid(bool on);
+	// Draw the plot onto a canvas, filling it
+ void paint(PlotCanvas&c);
+	// Keep the axes of the last paint while the data stays within them,
+	// so that update() only has to draw points added since. Ranges grow,
+	// with some room to spare, when the data goes beyond them.
+ void incremental(bool on) {incrementing=on; painted=false;}
+	// Bring a canvas painted before up to date: draw the points added
+	// to the traces since, or paint it all again when another canvas
+	// was painted since, or the ranges, the canvas size or the traces
+	// changed otherwise. True if repainted.
+ bool update(PlotCanvas&c);
+	// Draw the plot, width x height pixels, and write it to path:
+	// SVG, PDF or PPM for names ending in .svg, .pdf or .ppm, else PNG.
+	// false on failure, or when width or height is not positive
+ bool saveImage(const char*path, int width=640, int height=480);
+	// Show x0..x1 by y0..y1 rather than the whole data, from the next
+	// paint on: the ranges are taken as they are, without reading the
+	// data, and only the points in view are drawn, found by bisection
+	// when x is sorted. Lines are cut at the plot area. While zoomed,
+	// update() paints it all again.
+ void view(float_t x0, float_t x1, float_t y0, float_t y1);
+	// Back to the ranges of the whole data
+ void unzoom() {viewing=false; painted=false;}
+ bool zoomed() const {return viewing;}
+	// Zoom in by factor (out if less than 1) about pixel (x,y), pan by
+	// dx,dy pixels, or zoom onto the box between two pixels; pixels are
+	// those of the last paint. The window does so on mouse wheel, left
+	// drag and right drag.
+ void zoom(float_t factor, int x, int y);
+ void pan(int dx, int dy);
+ void zoomBox(int x0, int y0, int x1, int y1);
+#ifdef _WIN32
  static HWND wnd;
  static HDC dc;
- void onPaint();
+ void onPaint();	// paint on dc, on WM_PAINT
+ void update();		// update(PlotCanvas&) on the window
+private:
+ std::unique_ptr<PlotCanvas> frame;	// the window's picture, off-screen
+ PlotCanvas&buffer(PlotCanvas&win);	// frame, the size of win
+public:
+#endif
  struct attrib{
   Color colour;
   char penwidth;
@@ -38,11 +102,15 @@ public:
   char drawstyle;
  };
  struct xytrace{
-  const Plotdata*x;
+  const Plotdata*x;	// followed as it changes; 0 for a view
   const Plotdata*y;
+  Plotview vx,vy;	// when x and y are 0
   attrib a;
+  Plotview xview() const {return x ? Plotview(*x) : vx;}
+  Plotview yview() const {return y ? Plotview(*y) : vy;}
  };
 private:
+ PlotCanvas*canvas;	// canvas being painted
  Rect rcPlot;
 // int winWidth, winHeight;
 // int plotWidth, plotHeight;
@@ -50,11 +118,24 @@ private:
  float_t x_range, y_range; // Ranges of x values and y values
  float_t x_scale, y_scale; // Scales of graph drawing to screen pixels
  bool plotStarted;	// True while plotting is going on
+ bool decimating;	// True to reduce traces per pixel column
+ bool pyramids;		// True to draw large traces from a PlotLod
+ bool viewing;		// True to show viewX, viewY rather than the data
+ Plotdata::Range viewX, viewY;
+ Plotdata::Range guardX, guardY;	// the view and far around it, where lines are cut
+ double clipX, clipY;	// previous point of the trace, when clipPrev
+ bool clipPrev;
+ bool incrementing;	// True to keep the ranges for update()
+ bool painted;		// True when xr, yr and traces are as last drawn
+ const PlotCanvas*paintedOn;	// on this canvas
+ int paintedWidth, paintedHeight;
  bool marked; 		// True when a marker is visible
  int lastX;
  int lastY; 		// Location of last marker drawn
  Color colour;	// Current drawing colour
  Color lastColour;	// Previous drawing colour
+ std::unique_ptr<PlotCanvas> axes;	// layer of the last axes drawn
+ Plotdata::Range axesX, axesY;		// their ranges
 	   
 	/* Convert graph x value to screen coordinate */
  int X(float_t x) const;
@@ -72,6 +153,8 @@ private:
  bool withinRange(float_t xVal, float_t yVal) const;
 	/* Draws the axes */
  void drawAxes();
+	/* Copy the axes onto c from the layer, drawn again if stale */
+ bool copyAxes(PlotCanvas&c);
 	/* Watches the mouse and prints cursor coords if clicked */
 // bool watchMouse();
 	// Draw a marker at the current cursor position. Erase if erase is true
@@ -88,23 +171,58 @@ private:
  
  void drawPointShape(int x, int y) const;
  void drawMarkShape(int x, int y) const;
- void moveto(int x, int y) const {MoveToEx(dc,x,y,0);}
- void lineto(int x, int y) const {LineTo(dc,x,y);}
-// void linerel(int x, int y) const {POINT pt;GetCurrentPositionEx(dc,&pt);LineTo(dc,x+pt.x,y+pt.y);}
- void outtextxy(int x, int y,const char*s) const {TextOut(dc,x,y,s,strlen(s));}
- struct gdiobj{
-  HPEN penPlot;
-  HBRUSH brFill;
- };
+ void moveto(int x, int y) const {canvas->moveto(x,y);}
+ void lineto(int x, int y) const {canvas->lineto(x,y);}
  struct marker_t{
   float_t x,y;
+ };
+	/* Consecutive points falling into the same pixel column */
+ struct column_t{
+  int x;		// pixel column
+  int first,last;	// y of first and last point
+  int lo,hi,back;	// lowest and highest y, last y that differs from "last"
+  size_t n,ilo,ihi,iback;	// number of points, index of lo, hi and back
  };
  struct internal_xytrace{
   xytrace t;
   std::vector<marker_t>markers;
-  gdiobj g;
+  size_t drawn;		// number of points drawn
+  column_t col;		// where drawing goes on, if col.n (see drawNew())
+  std::unique_ptr<PlotLod> lod;	// levels of detail, when pyramids
+  size_t checked;	// points of x known to be sorted, if sorted
+  bool sorted;
  };
  std::vector<internal_xytrace> traces;
+	/* Ranges of the data; false if no trace can be drawn */
+ bool dataRange(Plotdata::Range&x, Plotdata::Range&y) const;
 	/* Draw the data */
  void drawFunc(internal_xytrace&t);
+	/* Draw the points of the trace after the ones already drawn, up to end */
+ void drawNew(internal_xytrace&t, size_t end=~size_t(0));
+	/* Build or drop the PlotLod of a trace, as its size asks */
+ void levels(internal_xytrace&t);
+	/* Draw those of them that its PlotLod summarizes */
+ void drawLod(internal_xytrace&t, size_t end);
+	/* Whether x is finite and sorted, checking the points added since */
+ bool sortedX(internal_xytrace&t, const Plotview&x, size_t n);
+	/* Points i0..i1-1 of the first n reach into the view */
+ void visible(internal_xytrace&t, const Plotview&x, size_t n, size_t&i0, size_t&i1);
+	/* Points i0..i1-1 of the trace, one at a time */
+ void drawPoints(const Plotview&x, const Plotview&y, size_t i0, size_t i1, column_t&c);
+	/* Draw block j of level k of the PlotLod */
+ void drawBlock(const PlotLod&lod, const Plotview&x, const Plotview&y,
+  unsigned k, size_t j, column_t&c);
+	/* Next point of the trace: cut at the guard box when viewing, then
+	   added to column c when decimating, else drawn */
+ void addPoint(column_t&c, float_t x, float_t y) {if (viewing) clipPoint(c,x,y); else drawPoint(c,x,y);}
+ void clipPoint(column_t&c, float_t x, float_t y);
+ void drawPoint(column_t&c, float_t x, float_t y) {if (decimating) toColumn(c,x,y); else plotPoint(c,x,y);}
+	/* Add a point to column c, drawing c when the point leaves it */
+ void toColumn(column_t&c, float_t x, float_t y);
+	/* Draw a line to the point, c.x and c.first being the last one */
+ void plotPoint(column_t&c, float_t x, float_t y);
+	/* Pen down to (x,y) if plotting is going on, else move there */
+ void plotto(int x, int y);
+	/* Draw the rest of a column, its first point is already drawn */
+ void drawColumn(const column_t&c) const;
 };
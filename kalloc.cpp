@@ -0,0 +1,66 @@
+/* Check of the allocations made by a Plotdata expression.
+ *
+ * y = sin(x * k) is evaluated straight into the elements of y (see
+ * PlotExpr.h), so it must allocate once, for those elements, and build no
+ * temporary. operator new is replaced by a counter; the elements come
+ * from it, or from plotAllocate() (PlotPool.h) when built with PLOT_POOL,
+ * counted by the bytes it gives out.
+ * Prints the allocations and exits with 1 when there are more than one.
+ *
+ * usage: kalloc [number_of_points]
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "koolplot.h"
+
+static size_t allocs=0;
+
+void*operator new(size_t n) {
+ allocs++;
+ void*p=malloc(n ? n : 1);
+ if (!p) throw std::bad_alloc();
+ return p;
+}
+void operator delete(void*p) noexcept {free(p);}
+void operator delete(void*p, size_t) noexcept {free(p);}
+
+// Bytes given out by plotAllocate() so far
+static size_t given() {
+ PlotPoolStats s=plotPoolStats();
+ return s.fresh+s.reused;
+}
+
+int main(int argc, char**argv) {
+ size_t n=argc>1 ? strtoul(argv[1],0,10) : 1000;
+ Plotdata x(0);
+ x.plotRange(0.0, 10.0, n);
+ float_t k=3;
+
+ size_t b0=given();
+ Plotdata copy(x);			// one block of x.size() elements
+ size_t block=given()-b0;
+
+ size_t a0=allocs;
+ b0=given();
+ Plotdata y=sin(x*k);
+ size_t bytes=given()-b0;
+ size_t count=allocs-a0+(bytes ? (bytes==block ? 1 : 2) : 0);
+
+ for (size_t i=0; i<x.size(); i++)
+  if (std::fabs(y[i]-std::sin(x[i]*k))>1e-5) {
+   printf("y[%lu] is %g, not %g\n", (unsigned long)i, (double)y[i],
+    (double)std::sin(x[i]*k));
+   return 1;
+  }
+ printf("y = sin(x * k), %lu points: %lu operator new, %lu bytes of elements (%lu in a block)\n",
+  (unsigned long)x.size(), (unsigned long)(allocs-a0), (unsigned long)bytes,
+  (unsigned long)block);
+ if (count>1) {
+  printf("more than one allocation\n");
+  return 1;
+ }
+ return 0;
+}
@@ -0,0 +1,66 @@
+/* Benchmark of the Plotdata element-wise kernels.
+ *
+ * Runs every operator on a large Plotdata once per instruction set level
+ * supported by this processor, and prints the time per element and the
+ * speedup over the plain C++ loop.
+ *
+ * usage: kbench [number_of_points]
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "PlotData.h"
+
+// Best of a few runs, in nanoseconds per element
+template<class F> static double timeit(F f, size_t n) {
+ double best=1e30;
+ for (int rep=0; rep<7; rep++) {
+  std::chrono::steady_clock::time_point t0=std::chrono::steady_clock::now();
+  f();
+  double ns=std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-t0).count();
+  if (ns<best) best=ns;
+ }
+ return best/n;
+}
+
+int main(int argc, char**argv) {
+ size_t n=argc>1 ? strtoul(argv[1],0,10) : 1<<22;
+ Plotdata x(1.0, 2.0, MEDIUM), y(1.0, 3.0, MEDIUM), r;
+ x.plotRange(1.0, 2.0, n);
+ y.plotRange(1.0, 3.0, n);
+
+ struct Bench{
+  const char*name;
+  double ns[ISA_AVX512+1];
+ }bench[]={{"x + y",{}},{"x - y",{}},{"x * y",{}},{"x / y",{}},
+           {"x + 3",{}},{"3 / x",{}},{"-x",{}},{"x ^ 3",{}}};
+ const int nbench=sizeof bench/sizeof*bench;
+
+ PlotIsa top=plotIsaDetected();
+ for (int isa=ISA_SCALAR; isa<=top; isa++) {
+  plotSetIsa(PlotIsa(isa));
+  bench[0].ns[isa]=timeit([&]{r=x+y;},n);
+  bench[1].ns[isa]=timeit([&]{r=x-y;},n);
+  bench[2].ns[isa]=timeit([&]{r=x*y;},n);
+  bench[3].ns[isa]=timeit([&]{r=x/y;},n);
+  bench[4].ns[isa]=timeit([&]{r=x+3;},n);
+  bench[5].ns[isa]=timeit([&]{r=3/x;},n);
+  bench[6].ns[isa]=timeit([&]{r=-x;},n);
+  bench[7].ns[isa]=timeit([&]{r=x^3;},n);
+ }
+
+ printf("%u points, sizeof(float_t)=%u, ns/point (speedup over scalar)\n",
+   unsigned(n),unsigned(sizeof(float_t)));
+ printf("%-8s","");
+ for (int isa=ISA_SCALAR; isa<=top; isa++) printf("%16s",plotIsaName(PlotIsa(isa)));
+ printf("\n");
+ for (int b=0; b<nbench; b++) {
+  printf("%-8s",bench[b].name);
+  for (int isa=ISA_SCALAR; isa<=top; isa++)
+   printf("%8.3f (%4.1fx)",bench[b].ns[isa],bench[b].ns[ISA_SCALAR]/bench[b].ns[isa]);
+  printf("\n");
+ }
+ plotSetIsa(top);
+ return 0;
+}
@@ -10,7 +10,7 @@
  */
 #include <cmath>
 
-#include "Koolplot.h"
+#include "koolplot.h"
 
 // ----------- more function prototypes -------  ----------------------
 // May be placed in the header file for user program access if they are
@@ -61,7 +61,7 @@ void point(Plotdata&xAxis, Plotdata&yAxis,float_t xCoord, float_t yCoord) {
  * @param array The array of points to insert
  * @param numToInsert the number of points to add from the array.
  */
-void insert(Plotdata& axis, const float_t array[], int numToInsert) {
+void insert(Plotdata& axis, const float_t array[], size_t numToInsert) {
  axis.insert(array, numToInsert);
 }
 
@@ -88,13 +88,15 @@ void plot(const Plotdata&x,const Plotdata&y,Color colour,const char*label) {
  ps.plot(x, y, colour);
 } 
 
+static bool adaptiveSampling=false;
+
+void adaptive(bool on) {adaptiveSampling=on;}
+
 /**
  * Plot f(x) function, specify label (use together with f(x) function)
  */
 void plot(const Plotdata&x,Func&aFunction,const char*label) {
- if (!aFunction) return;
- Plotstream ps(label);
- ps.plot(x, x.doFunc(aFunction));
+ plot(x,aFunction,GREEN,label);
 } 
 /*
  * Plot f(x) function, specify curve colour
@@ -102,7 +104,13 @@ void plot(const Plotdata&x,Func&aFunction,const char*label) {
 void plot(const Plotdata&x,Func&aFunction,Color colour,const char*label) {
  if (!aFunction) return;
  Plotstream ps(label);
- ps.plot(x, x.doFunc(aFunction), colour);
+ if (adaptiveSampling) {
+  Plotdata::Range r;
+  Plotdata::rangeXY(x,x,r,r);
+  Plotdata xs, ys;
+  Plotdata::sample(aFunction,r.min,r.max,xs,ys);
+  ps.plot(xs, ys, colour);
+ }else ps.plot(x, x.doFunc(aFunction), colour);
 } 
 
 /**
@@ -133,79 +141,3 @@ BinFunc&f2(Plotdata&x) {
 Plotdata f2(const Plotdata&x, float_t op2) {
  return x.doBinFunc(op2);
 }
-
-/*~~~~~~~~~~~~~~~~~~~~~~~~~~ MATH.H FUNCTIONS ~~~~~~~~~~~~~~~~~~~~~~~~~*/
-/*
- * Return new data, the sine of the original data
- */
-Plotdata sin(const Plotdata&pd) {return pd.doFunc(sin);}
-
-/*
- * Return new data, the cosine of the original data
- */
-Plotdata cos(const Plotdata&pd) {return pd.doFunc(cos);}
-
-/*
- * Return new data, the tan of the original data
- */
-Plotdata tan(const Plotdata&pd) {return pd.doFunc(tan);}
-
-/*
- * Return new data, the asin of the original data
- */
-Plotdata asin(const Plotdata&pd) {return pd.doFunc(asin);}
-
-/*
- * Return new data, the acos of the original data
- */
-Plotdata acos(const Plotdata&pd) {return pd.doFunc(acos);}
-
-/*
- * Return new data, the atan of original the data
- */
-Plotdata atan(const Plotdata&pd) {return pd.doFunc(atan);}
-
-/*
- * Return new data, the hyperbolic sine of the original data
- */
-Plotdata sinh(const Plotdata&pd) {return pd.doFunc(sinh);}
-
-/*
- * Return new data, the hyperbolic cosine of the original data
- */
-Plotdata cosh(const Plotdata&pd) {return pd.doFunc(cosh);}
-
-/*
- * Return new data, the hyperbolic tan of the original data
- */
-Plotdata tanh(const Plotdata&pd) {return pd.doFunc(tanh);}
-
-/*
- * Return new data, the square root of the original data
- */
-Plotdata sqrt(const Plotdata&pd) {return pd.doFunc(sqrt);}
-
-/*
- * Return new data, the absolute value of the original data
- */
-Plotdata fabs(const Plotdata&pd) {return pd.doFunc(fabs);}
-
-/*
- * Return new data, the natural logarithm of the original data
- */
-Plotdata log(const Plotdata&pd) {return pd.doFunc(log);}
-
-/*
- * Return new data, the log (base 10)l of the original data
- */
-Plotdata log10(const Plotdata&pd) {return pd.doFunc(log10);}
-
-/*
- * Return new data, the exponential of the original data
- */
-Plotdata exp(const Plotdata&pd) {return pd.doFunc(exp);}
-
-/*
- * Return new data, the power "exp" of the original data
- */
-Plotdata pow(const Plotdata&pd, float_t exp) {return pd.doBinFunc(pow,exp);}
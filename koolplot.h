@@ -44,6 +44,14 @@ void plot(const Plotdata&x,Func&f,Color colour,const char *label=0);
 /** Plot f(x) function, specify label and curve colour (use together with f(x) function) */
 inline void plot(const Plotdata&x,Func&f,const char *l,Color c) {plot(x,f,c,l);}
 
+/**
+ * Adaptive plots of f(x) functions: when on, plot(x, f(x)) evaluates f
+ * over the range of x where the curve needs it (see Plotdata::sample())
+ * rather than at each point of x, and breaks the curve where f jumps.
+ * Off by default.
+ */
+void adaptive(bool on);
+
 /**
  * Installs a user-defined unary function of x as f(x)
  * example: Plotdata x(-6, 6);
@@ -67,6 +75,28 @@ BinFunc&f2(Plotdata&x);
  */
 Plotdata f2(const Plotdata&x, float_t op2);
 
+/**
+ * Holds any callable as the function of f(x): a lambda, which may capture
+ * parameters rather than take them from globals, or a function object.
+ * It is called directly, so the compiler can inline it, and the result
+ * is an expression like sin(x), evaluated in one pass (PlotExpr.h).
+ * example: Plotdata x(-6, 6);
+ *			float_t k = 3;
+ *			plot(x, f(x, [k](float_t v) {return sin(k*v)/v;}));
+ */
+template<class E,class F> inline PlotCall<E,typename std::decay<F>::type>
+ f(const PlotExpr<E>&x, F&&fn) {return PlotCall<E,typename std::decay<F>::type>(x.self(),fn);}
+
+/**
+ * The same with a binary callable and its second operand, as f2(x, op2)
+ * example: plot(x, f2(x, [](float_t v, float_t max) {return v<max ? v : NOPLOT;}, 10));
+ */
+template<class E,class F> inline PlotCall<E,PlotBind<typename std::decay<F>::type> >
+ f2(const PlotExpr<E>&x, F&&fn, float_t op2) {
+ PlotBind<typename std::decay<F>::type> b={fn,op2};
+ return PlotCall<E,PlotBind<typename std::decay<F>::type> >(x.self(),b);
+}
+
 /**
  * Adds next point to plotting data
  * -You add x and y coordinates in 2 separate Plotdatas then call plot(). 
@@ -98,7 +128,7 @@ void point(Plotdata&xAxis, Plotdata&yAxis,
  * @param array The array of points to insert
  * @param numToInsert the number of points to add from the array.
  */
-void insert(Plotdata& axis, const float_t array[], int numToInsert);
+void insert(Plotdata& axis, const float_t array[], size_t numToInsert);
 
 /** Sets the bottom left corner of the graph axes 
   * xmin and ymin should be less than or equal to any coordinate
@@ -139,96 +169,133 @@ void clear(Plotdata& pd);
 
 /**********************************************************************/
 /*________ Maths functions that may be used to define functions ______*/
+/* They take a Plotdata or any arithmetic expression of Plotdatas and
+ * are evaluated lazily, together with the rest of the expression
+ * (see PlotExpr.h). */
 
 /*
  * Return new data, the sine of the original data
  * @param pd the original Plotdata
  */
-Plotdata sin(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotSin> sin(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotSin>(pd.self());}
 
 /**
  * Return new data, the cosine of the original data
  * @param pd the original Plotdata
  */
-Plotdata cos(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotCos> cos(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotCos>(pd.self());}
 
 /**
  * Return new data, the tan of the original data
  * @param pd the original Plotdata
  */
-Plotdata tan(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotTan> tan(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotTan>(pd.self());}
 
 /**
  * Return new data, the asin of the original data
  * @param pd the original Plotdata
  */
-Plotdata asin(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotAsin> asin(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotAsin>(pd.self());}
 
 /**
  * Return new data, the acos of the original data
  * @param pd the original Plotdata
  */
-Plotdata acos(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotAcos> acos(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotAcos>(pd.self());}
 
 
 /**
  * Return new data, the atan of the original data
  * @param pd the original Plotdata
  */
-Plotdata atan(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotAtan> atan(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotAtan>(pd.self());}
 
 /**
  * Return new data, the hyperbolic sine of the original data
  * @param pd the original Plotdata
  */
-Plotdata sinh(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotSinh> sinh(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotSinh>(pd.self());}
 
 /**
  * Return new data, the hyperbolic cosine of the original data
  * @param pd the original Plotdata
  */
-Plotdata cosh(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotCosh> cosh(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotCosh>(pd.self());}
 
 /**
  * Return new data, the hyperbolic tan of the original data
  * @param pd the original Plotdata
  */
-Plotdata tanh(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotTanh> tanh(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotTanh>(pd.self());}
 
 /**
  * Return new data, the square root of the original data
  * @param pd the original Plotdata
  */
-Plotdata sqrt(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotSqrt> sqrt(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotSqrt>(pd.self());}
 
 /**
  * Return new data, the absolute value of the original data
  * @param pd the original Plotdata
  */
-Plotdata fabs(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotFabs> fabs(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotFabs>(pd.self());}
 
 /**
  * Return new data, the natural logarithm of the original data
  * @param pd the original Plotdata
  */
-Plotdata log(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotLog> log(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotLog>(pd.self());}
 
 /**
  * Return new data, the log (base 10)l of the original data
  * @param pd the original Plotdata
  */
-Plotdata log10(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotLog10> log10(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotLog10>(pd.self());}
 
 /**
  * Return new data, the exponential of the original data
  * @param pd the original Plotdata
  */
-Plotdata exp(const Plotdata& pd);
+template<class E> inline PlotUnary<E,PlotExp> exp(const PlotExpr<E>& pd)
+ {return PlotUnary<E,PlotExp>(pd.self());}
+
+// The same on a temporary Plotdata, whose elements the result takes (PlotData.h)
+#define PLOT_TEMP_FUNC(fn,Op) \
+inline PlotUnary<PlotTemp,Op> fn(Plotdata&& pd) {return PlotUnary<PlotTemp,Op>(PlotTemp(pd));}
+PLOT_TEMP_FUNC(sin,PlotSin)
+PLOT_TEMP_FUNC(cos,PlotCos)
+PLOT_TEMP_FUNC(tan,PlotTan)
+PLOT_TEMP_FUNC(asin,PlotAsin)
+PLOT_TEMP_FUNC(acos,PlotAcos)
+PLOT_TEMP_FUNC(atan,PlotAtan)
+PLOT_TEMP_FUNC(sinh,PlotSinh)
+PLOT_TEMP_FUNC(cosh,PlotCosh)
+PLOT_TEMP_FUNC(tanh,PlotTanh)
+PLOT_TEMP_FUNC(sqrt,PlotSqrt)
+PLOT_TEMP_FUNC(fabs,PlotFabs)
+PLOT_TEMP_FUNC(log,PlotLog)
+PLOT_TEMP_FUNC(log10,PlotLog10)
+PLOT_TEMP_FUNC(exp,PlotExp)
+#undef PLOT_TEMP_FUNC
 
 /**
  * Return new data, the power "exp" of the original data
  * @param pd  the original Plotdata
  * @param exp value of the exponent to raise the data to.
  */
-Plotdata pow(const Plotdata& pd, float_t exp);
+template<class E> inline PlotScalarR<E,PlotPow> pow(const PlotExpr<E>& pd, float_t exp)
+ {return PlotScalarR<E,PlotPow>(pd.self(),exp);}
 
@@ -22,29 +22,161 @@
 #include <limits>
 
 #include "PlotData.h" 
+#include "PlotThreads.h"
 
 /* 
  * Constructors
  */
 
 Plotdata::Plotdata(float_t lo, float_t hi, Grain grain)
-: userFunction(0), userBinFunction(0)
+: ext(0), userFunction(0), userBinFunction(0), cached(false)
 {
 	plotRange(lo, hi, grain);
 }
 
-Plotdata::Plotdata(const float_t*array, int dataSize)
-: data(array, array + dataSize), userFunction(0), userBinFunction(0)
+Plotdata::Plotdata(const float_t*array, size_t dataSize)
+: data(array, array + dataSize), ext(0), userFunction(0), userBinFunction(0), cached(false)
 {}
 
+Plotdata::Plotdata(Plotdata && other)
+: ext(0), userFunction(other.userFunction), userBinFunction(other.userBinFunction), cached(false)
+{
+	take(other);
+}
+
+Plotdata & Plotdata::operator = (Plotdata && other)
+{
+	if (&other != this)
+	{
+		userFunction = other.userFunction;
+		userBinFunction = other.userBinFunction;
+		take(other);
+	}
+	return *this;
+}
+
+// Take the elements of other, in whatever mode, leaving it empty
+void Plotdata::take(Plotdata & other)
+{
+	data = std::move(other.data);
+	ext = other.ext;
+	extSize = other.extSize;
+	mapping = std::move(other.mapping);
+	ringCap = other.ringCap;
+	ringHead = other.ringHead;
+	ringSize = other.ringSize;
+	ringBlocks = std::move(other.ringBlocks);
+	cache = other.cache;
+	nonfinite = other.nonfinite;
+	cached = other.cached;
+	other.release();
+	other.data.clear();
+	other.ringBlocks.clear();
+	other.cached = false;
+}
+
+// Copy the elements of a mapped file or of a ring into a plain data
+void Plotdata::copyIn() const
+{
+	PlotBuffer d(begin(), end());
+	data.swap(d);
+	ext = 0;
+	mapping.reset();
+	ringCap = 0;
+	vector<RingBlock>().swap(ringBlocks);
+}
+
+void Plotdata::clear()
+{
+	if (ringCap)
+	{
+		ringHead = ringSize = 0;
+		for (size_t i = 0; i < ringBlocks.size(); i++)
+		{
+			ringBlocks[i].r.init();
+			ringBlocks[i].nonfinite = 0;
+		}
+	}
+	else
+	{
+		release();
+		data.clear();
+	}
+	cache.init();
+	nonfinite = 0;
+	cached = true;
+}
+
+// Switch to ring mode, keeping the last elements
+void Plotdata::ring(size_t capacity)
+{
+	if (!capacity)
+	{
+		own();
+		return;
+	}
+	size_t n = min(size(), capacity);
+	vector<float_t> last(end() - n, end());
+	release();
+	data.assign(2 * capacity, 0);
+	ringCap = capacity;
+	ringBlocks.resize((capacity + ringBlock - 1) / ringBlock);
+	clear();
+	for (size_t i = 0; i < n; i++)
+		push(last[i]);
+}
+
+// Append to a ring
+void Plotdata::push(float_t v)
+{
+	size_t p = ringHead + ringSize; // where v goes
+	if (p >= ringCap)
+		p -= ringCap;
+	if (ringSize < ringCap)
+		ringSize++;
+	else // overwrite the oldest element
+	{
+		float_t old = data[p];
+		if (++ringHead == ringCap)
+			ringHead = 0;
+		if (cached)
+		{
+			if (!isfinite(old))
+				nonfinite--;
+			else if (old == cache.min || old == cache.max)
+				cached = false; // the range may shrink
+		}
+	}
+	data[p] = data[p + ringCap] = v;
+	RingBlock & b = ringBlocks[p / ringBlock];
+	if (p % ringBlock == 0) // entering the block
+	{
+		b.r.init();
+		b.nonfinite = 0;
+	}
+	if (isfinite(v))
+		b.r.expand(v);
+	else
+		b.nonfinite++;
+	grow(v);
+}
+
 /*  
  * Member Functions
  */
 // Insert dataSize elements from array into Plotdata
-void Plotdata::insert(const float_t array[], int dataSize)
+void Plotdata::insert(const float_t array[], size_t dataSize)
 {
     // Append, rather than insert at the start
+    if (ringCap)
+    {
+        for (size_t i = 0; i < dataSize; i++) push(array[i]);
+        return;
+    }
+    own();
+    room(dataSize);
     copy(array, array + dataSize, back_inserter(data));
+    for (size_t i = 0; i < dataSize; i++) grow(array[i]);
     // data = vector<double>(array, array + dataSize);
 }
 
@@ -70,7 +202,9 @@ void Plotdata::plotRange(float_t lo,float_t hi,size_t numpoints,LogSpace isLog)
 		return;
 		
 	   
+	release();
 	data.clear(); 
+	cached = false;
 	
 	if( !isLog)
 	{
@@ -115,180 +249,66 @@ void Plotdata::plotRange(float_t lo,float_t hi,size_t numpoints,LogSpace isLog)
 	data.push_back(hi);
 }
 
-Plotdata Plotdata::operator + (const Plotdata & other) const
-{
-    int thisSize = data.size(),
-        otherSize = other.data.size();
-    
-	// Size of returned data is that of the smallest of the two
-	size_t len = thisSize < otherSize ? thisSize : otherSize;
-	
-	vector<float_t> vec(len);
-	transform(data.begin(),
-		 	  data.begin() + len, 
-		 	  other.data.begin(),
-			  vec.begin(),
-		 	  plus<float_t>());
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator + (float_t val) const
-{
-	vector<float_t> vec(data.size());
-	transform(data.begin(),
-		 	  data.end(), 
-			  vec.begin(),
-		 	  bind2nd(plus<float_t>(), val));
-	return Plotdata(vec);
-}
-
-Plotdata operator + (float_t op1, const Plotdata & pd)
-{
-	vector<float_t> vec(pd.data.size());
-	transform(pd.data.begin(),
-		 	  pd.data.end(), 
-			  vec.begin(),
-		 	  bind2nd(plus<float_t>(), op1));
-	return Plotdata(vec);
-}
-	   
-Plotdata Plotdata::operator - (const Plotdata & other) const
-{
-	// Size of returned data is that of the smallest of the two
-	size_t len = size() > other.size() ? size() : other.size();
-	
-	vector<float_t> vec(len);
-	transform(data.begin(),
-		 	  data.begin() + len, 
- 	  	      other.data.begin(),
-			  vec.begin(),
-		 	  minus<float_t>());
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator - (float_t val) const
-{
-	vector<float_t> vec(data.size());
-	transform(data.begin(),
-		 	  data.end(), 
-			  vec.begin(),
-		 	  bind2nd(minus<float_t>(), val));
-	return Plotdata(vec);
-}
-
-Plotdata operator - (float_t op1, const Plotdata & pd)
-{
-	vector<float_t> vec(pd.data.size());
-	transform(pd.data.begin(),
-		 	  pd.data.end(), 
-			  vec.begin(),
-		 	  bind2nd(minus<float_t>(), op1));
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator * (const Plotdata & other) const
-{
-	// Size of returned data is that of the smallest of the two
-	size_t len = size() > other.size() ? size() : other.size();
-	
-	vector<float_t> vec(len);
-	transform(data.begin(),
-		 	  data.begin() + len, 
-	   	      other.data.begin(),
-			  vec.begin(),
-		 	  multiplies<float_t>());
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator * (float_t val) const
-{
-	vector<float_t> vec(data.size());
-	transform(data.begin(),
-		 	  data.end(), 
-			  vec.begin(),
-		 	  bind2nd(multiplies<float_t>(), val));
-	return Plotdata(vec);
-}
-
-Plotdata operator * (float_t op1, const Plotdata & pd)
-{
-	vector<float_t> vec(pd.data.size());
-	transform(pd.data.begin(),
-		 	  pd.data.end(), 
-			  vec.begin(),
-		 	  bind2nd(multiplies<float_t>(), op1));
-	return Plotdata(vec);
-}
-
- 
-Plotdata Plotdata::operator / (const Plotdata & other) const
+// Concatenation operator
+Plotdata & Plotdata::operator << (const Plotdata & toadd)
 {
-	// Size of returned data is that of the smallest of the two
-	size_t len = size() > other.size() ? size() : other.size();
+	if (ringCap)
+	{
+		vector<float_t> copy; // toadd may be *this
+		const float_t * p = toadd.begin();
+		if (&toadd == this)
+		{
+			copy.assign(begin(), end());
+			p = copy.data();
+		}
+		for (size_t i = 0, n = toadd.size(); i < n; i++)
+			push(p[i]);
+		return *this;
+	}
+	own();
+	size_t n = toadd.size();
+	room(n); // toadd may be *this: no reallocation below
+	data.insert(data.end(), toadd.begin(), toadd.end());
+	if (cached && toadd.cached)
+	{
+		cache.expand(toadd.cache);
+		nonfinite += toadd.nonfinite;
+	}
+	else // toadd may be *this, use the copy
+		for (size_t i = data.size() - n; i < data.size(); i++)
+			grow(data[i]);
 	
-	vector<float_t> vec(len);
-	transform(data.begin(),
-		 	  data.begin() + len, 
-			  other.data.begin(),
-			  vec.begin(),
-		 	  divides<float_t>());
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator / (float_t val) const
-{
-	vector<float_t> vec(data.size());
-	transform(data.begin(),
-		 	  data.end(), 
-			  vec.begin(),
-		 	  bind2nd(divides<float_t>(), val));
-	return Plotdata(vec);
-}
-
-Plotdata Plotdata::operator ^ (float_t val) const
-{
-	vector<float_t> vec(data.size());
-	transform(data.begin(),
-		 	  data.end(), 
-			  vec.begin(),
-		 	  bind2nd(ptr_fun(powl), val));
-	return Plotdata(vec);
-}
-
-
-Plotdata operator / (float_t op1, const Plotdata & pd)
-{
-	vector<float_t> vec(pd.data.size());
-	transform(pd.data.begin(),
-		 	  pd.data.end(), 
-			  vec.begin(),
-		 	  bind2nd(divides<float_t>(), op1));
-	return Plotdata(vec);
+	return *this; // This makes the << operator transitive
 }
 
-
-Plotdata Plotdata::operator - ( ) const
+// Concatenation of a temporary: its elements, if there are none yet
+Plotdata & Plotdata::operator << (Plotdata && toadd)
 {
-	vector<float_t> vec(data);
-	transform(vec.begin(),
-		 	  vec.end(), 
-		 	  vec.begin(),
-		 	  negate<float_t>());
-	return Plotdata(vec);
+	if (size() || ext || ringCap || toadd.ext || toadd.ringCap || &toadd == this)
+		return *this << (const Plotdata &)toadd;
+	data.swap(toadd.data);
+	cache = toadd.cache;
+	nonfinite = toadd.nonfinite;
+	cached = toadd.cached;
+	toadd.cached = false;
+	return *this;
 }
 
-// Concatenation operator
-Plotdata & Plotdata::operator << (const Plotdata & toadd)
+// Append n elements, for the caller to write
+float_t * Plotdata::append(size_t n)
 {
-	data.insert(data.end(), toadd.data.begin(), toadd.data.end());
-	
-	return *this; // This makes the << operator transitive
+	own();
+	room(n);
+	size_t s = data.size();
+	data.resize(s + n);
+	cached = false;
+	return data.data() + s;
 }
 
 // add a double to the data
 Plotdata & Plotdata::operator << (float_t toadd)
 {
-	data.push_back(toadd);
+	point(toadd);
 	return *this;
 }
 
@@ -304,71 +324,140 @@ public:
     }
 };
 
+// Recompute the cached range of the finite elements
+void Plotdata::recache() const{
+ if (ringCap) {ringRange(); return;}
+ float_t r[4];
+ nonfinite = size() - plotKernelRange(begin(), 0, size(), r);
+ cache.init(r[0], r[1]);
+ cached=true;
+}
+
+// Range of a ring, from its blocks and the old elements left in the block
+// being written to
+void Plotdata::ringRange() const{
+ Range r;
+ r.init();
+ size_t bad = 0;
+ for (size_t i = 0; i < ringBlocks.size(); i++) {
+  r.expand(ringBlocks[i].r);
+  bad += ringBlocks[i].nonfinite;
+ }
+ size_t p = ringHead;		// where the next element goes when full
+ if (ringSize == ringCap && p % ringBlock) {
+  size_t m = min(p - p % ringBlock + ringBlock, ringCap) - p;
+  float_t q[4];
+  bad += m - plotKernelRange(data.data() + p, 0, m, q);
+  r.expand(q[0], q[1]);
+ }
+ cache = r;
+ nonfinite = bad;
+ cached = true;
+}
+
 /**
  * Class (static) function
  * Retrieves the maximums of each of x and y in a Plotdata pair
  * Values corresponding to a NOPLOT in the other Plotdata are not included;
  * Assign their respective maximums to xMax and yMax; NOPLOT if either does
  * not have a valid maximum.
+ *
+ * When x and y have the same size and no NOPLOT, these are the ranges
+ * cached by each Plotdata, computed once and updated by appends.
  */
 void Plotdata::rangeXY(const Plotdata&x,const Plotdata&y,Range&xr,Range&yr) {
- xr.init(); yr.init();
-    // Only search if both vectors contain some values
- if (x.data.size() && y.data.size()){
-  dataIterator xIter = x.data.begin();
-  dataIterator yIter = y.data.begin();
-  dataIterator xEnd  = x.data.end();
-  dataIterator yEnd  = y.data.end();
-        
-  for (; xIter != xEnd && yIter != yEnd; xIter++, yIter++) {
-   if (isfinite(*xIter) && isfinite(*yIter)) {
-    xr.expand(*xIter);
-    yr.expand(*yIter);
+ if (x.size() == y.size()) {
+  if (!x.cached) x.recache();
+  if (!y.cached) y.recache();
+  if (!x.nonfinite && !y.nonfinite) {
+   xr = x.cache;
+   yr = y.cache;
+   return;
+  }
+ }
+    // Joint scan, vectorized and threaded (see PlotKernels.h)
+ float_t r[4];
+ plotKernelRange(x.begin(), y.begin(), min(x.size(), y.size()), r);
+ xr.init(r[0], r[1]);
+ yr.init(r[2], r[3]);
+}
+
+void Plotdata::rangeXY(const Plotview&x,const Plotview&y,Range&xr,Range&yr) {
+ float_t r[4];
+ size_t n=min(x.size(), y.size());
+	// files read in chunks: the ranges saved in them, when they tell
+ uint64_t xbad, ybad;
+ if (x.chunks() && y.chunks() && x.size()==y.size()
+  && x.chunks()->range(xr,xbad) && y.chunks()->range(yr,ybad) && !xbad && !ybad)
+  return;
+ if (x.isNative() && y.isNative())
+  plotKernelRange(x.data(), x.stride(), y.data(), y.stride(), n, r);
+ else{
+	// converted a block at a time, and the blocks' ranges joined
+  const float_t inf=numeric_limits<float_t>::infinity();
+  unsigned parts=plotParts(n,1<<16);
+  vector<float_t> part(4*parts);
+  plotParallel(parts,n,[&](unsigned k,size_t i0,size_t i1){
+   float_t*p=&part[4*k];
+   p[0]=p[2]=inf;
+   p[1]=p[3]=-inf;
+   float_t bx[PLOT_BLOCK],by[PLOT_BLOCK],b[4];
+   for (size_t i=i0; i<i1; i+=PLOT_BLOCK) {
+    size_t m=i1-i<PLOT_BLOCK ? i1-i : PLOT_BLOCK;
+    if (!plotKernelRange(x.block(i,m,bx),y.block(i,m,by),m,b)) continue;
+    p[0]=min(p[0],b[0]); p[1]=max(p[1],b[1]);
+    p[2]=min(p[2],b[2]); p[3]=max(p[3],b[3]);
    }
+  });
+  r[0]=r[2]=inf;
+  r[1]=r[3]=-inf;
+  for (unsigned k=0; k<parts; k++) {
+   r[0]=min(r[0],part[4*k]); r[1]=max(r[1],part[4*k+1]);
+   r[2]=min(r[2],part[4*k+2]); r[3]=max(r[3],part[4*k+3]);
   }
  }
+ xr.init(r[0], r[1]);
+ yr.init(r[2], r[3]);
 }
 
 // Return new plot data with unary function applied to each 
 // original data elements values
 Plotdata Plotdata::doFunc(Func aFunction) const{
  Plotdata ret(size()); 
- transform(data.begin(), data.end(), ret.data.begin(), aFunction);
+ callEach(begin(), ret.data.data(), size(), aFunction);
  return ret;
 }	 
 
 // Return new plot data with binary function applied to each original
 // data elements values and op2 as the second function param
 Plotdata Plotdata::doBinFunc(BinFunc aFunc, float_t op2) const{
+ PlotBind<BinFunc> b={aFunc, op2};
  Plotdata ret(size()); 
- transform(data.begin(), data.end(), ret.data.begin(),
- bind2nd(ptr_fun(aFunc), op2));
+ callEach(begin(), ret.data.data(), size(), b);
  return ret;
 }	 
 
 // Return new plot data with user binary function applied to each
 // original data elements values and op2 as the second function param
 Plotdata Plotdata::doBinFunc(float_t op2) const{
- Plotdata ret(size()); 
- transform(data.begin(), data.end(), ret.data.begin(),
-   bind2nd(ptr_fun(userBinFunction), op2));
- return ret;
+ return doBinFunc(userBinFunction, op2);
 }	 
 
 
 ostream& operator<< (ostream&out, const Plotdata&pd){
- out << endl << pd.data.size() << endl;
- copy(pd.data.begin(), pd.data.end(), ostream_iterator<float_t>(out, " "));
+ out << endl << pd.size() << endl;
+ copy(pd.begin(), pd.end(), ostream_iterator<float_t>(out, " "));
  return out;
 }
 
 istream& operator>> (istream&in, Plotdata&pd){
- int size;
+ size_t size;
  float_t val;
- in >> size;
- for(int i = size; i > 0; i--){
-  in >> val;
-  pd.data.push_back(val);
+ if (!(in >> size)) return in;
+ if (!pd.ringCap) {
+  pd.own();
+  pd.room(min(size,size_t(1)<<20));	// a count read is not trusted further
  }
+ for(; size > 0 && in >> val; size--) pd.point(val);
  return in;
 }
@@ -0,0 +1,332 @@
+/* File: plotfile.cpp
+ *
+ * Binary files of Plotdata, and class PlotMap (see PlotFile.h).
+ * Class Plotchunks, reading such files in chunks (see PlotChunks.h).
+ */
+#define _FILE_OFFSET_BITS 64		// files over 2 GB on 32-bit systems
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "PlotData.h"
+#include "PlotFile.h"
+
+#ifdef _WIN32
+// windows.h is in PlotData.h
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char magic[8]={'K','O','O','L','P','L','O','T'};
+
+/* -------------------------------------------------------- */
+// PlotMap
+
+#ifdef _WIN32
+
+PlotMap::PlotMap(const char*path):p(0),n(0),file(INVALID_HANDLE_VALUE),map(0) {
+ file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,0);
+ if (file==INVALID_HANDLE_VALUE) return;
+ LARGE_INTEGER sz;
+ if (!GetFileSizeEx(file,&sz) || !sz.QuadPart || uint64_t(sz.QuadPart)>size_t(-1)) return;
+ map=CreateFileMapping(file,0,PAGE_READONLY,0,0,0);
+ if (!map) return;
+ p=MapViewOfFile(map,FILE_MAP_READ,0,0,0);
+ if (p) n=size_t(sz.QuadPart);
+}
+
+PlotMap::~PlotMap() {
+ if (p) UnmapViewOfFile(p);
+ if (map) CloseHandle(map);
+ if (file!=INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+
+#else
+
+PlotMap::PlotMap(const char*path):p(0),n(0) {
+ int fd=::open(path,O_RDONLY);
+ if (fd<0) return;
+ struct stat st;
+ if (!fstat(fd,&st) && st.st_size>0 && uint64_t(st.st_size)<=size_t(-1)) {
+  void*m=mmap(0,size_t(st.st_size),PROT_READ,MAP_SHARED,fd,0);
+  if (m!=MAP_FAILED) {p=m; n=size_t(st.st_size);}
+ }
+ ::close(fd);			// the mapping stays
+}
+
+PlotMap::~PlotMap() {
+ if (p) munmap(p,n);
+}
+
+#endif
+
+/* -------------------------------------------------------- */
+// Plotdata
+
+// float_t is float or double
+static const PlotFileHeader::Type nativeType=
+  sizeof(float_t)==4 ? PlotFileHeader::FLOAT32 : PlotFileHeader::FLOAT64;
+
+bool Plotdata::save(const char*path) const{
+ if (!cached) recache();
+ PlotFileHeader h;
+ memset(&h,0,sizeof h);
+ memcpy(h.magic,magic,sizeof magic);
+ h.version=PlotFileHeader::VERSION;
+ h.order=PlotFileHeader::ORDER;
+ h.count=size();
+ h.flags=PlotFileHeader::RANGE;
+ h.min=cache.min;
+ h.max=cache.max;
+ h.nonfinite=nonfinite;
+ h.type=nativeType;
+ FILE*f=fopen(path,"wb");
+ if (!f) return false;
+ bool ok=fwrite(&h,sizeof h,1,f)==1 && fwrite(begin(),sizeof(float_t),size(),f)==size();
+ return !fclose(f) && ok;
+}
+
+bool Plotdata::open(const char*path) {
+ shared_ptr<PlotMap> m(new PlotMap(path));
+ if (!m->ok() || m->size()<sizeof(PlotFileHeader)) return false;
+ PlotFileHeader h;
+ memcpy(&h,m->data(),sizeof h);
+ if (memcmp(h.magic,magic,sizeof magic) || h.version!=PlotFileHeader::VERSION
+  || h.order!=PlotFileHeader::ORDER) return false;
+ size_t es=h.type==PlotFileHeader::FLOAT32 ? 4 : h.type==PlotFileHeader::FLOAT64 ? 8 : 0;
+ if (!es || h.count>(m->size()-sizeof h)/es) return false;
+ const unsigned char*p=m->data()+sizeof h;
+ if (h.type==nativeType) {			// use in place
+  release();
+  PlotBuffer().swap(data);
+  ext=(const float_t*)p;
+  extSize=size_t(h.count);
+  mapping=m;
+ }else{						// convert
+  release();
+  data.resize(size_t(h.count));
+  for (size_t i=0; i<data.size(); i++) {
+   if (es==4) {float v; memcpy(&v,p+4*i,4); data[i]=v;}
+   else {double v; memcpy(&v,p+8*i,8); data[i]=float_t(v);}
+  }
+ }
+ cached=(h.flags&PlotFileHeader::RANGE) && h.type==nativeType;
+ if (cached) {
+  cache.init(float_t(h.min),float_t(h.max));
+  nonfinite=size_t(h.nonfinite);
+ }
+ return true;
+}
+
+/* -------------------------------------------------------- */
+// Plotchunks
+
+struct Plotchunks::Store{
+ struct Page{size_t index; vector<float_t> v;};
+ size_t chunk,pages;			// elements per chunk, chunks kept at most
+ size_t es;				// bytes per element in the file
+ uint64_t count;
+ PlotFileHeader h;
+ std::list<Page> lru;			// the most recently used first
+ std::unordered_map<size_t,std::list<Page>::iterator> where;
+ std::mutex lock;
+ uint64_t reads;
+#ifdef _WIN32
+ HANDLE file;
+ Store():count(0),reads(0),file(INVALID_HANDLE_VALUE) {}
+ bool isOpen() const {return file!=INVALID_HANDLE_VALUE;}
+ void close() {if (isOpen()) CloseHandle(file); file=INVALID_HANDLE_VALUE;}
+ bool open(const char*path, uint64_t&size) {
+  file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,0);
+  LARGE_INTEGER sz;
+  if (!isOpen() || !GetFileSizeEx(file,&sz)) return false;
+  size=uint64_t(sz.QuadPart);
+  return true;
+ }
+ bool read(uint64_t offset, void*p, size_t bytes) {
+  for (char*q=(char*)p; bytes; ) {
+   OVERLAPPED o;
+   memset(&o,0,sizeof o);
+   o.Offset=DWORD(offset);
+   o.OffsetHigh=DWORD(offset>>32);
+   DWORD m=bytes<(1u<<30) ? DWORD(bytes) : 1u<<30, got;
+   if (!ReadFile(file,q,m,&got,&o) || !got) return false;
+   q+=got; offset+=got; bytes-=got;
+  }
+  return true;
+ }
+#else
+ int fd;
+ Store():count(0),reads(0),fd(-1) {}
+ bool isOpen() const {return fd>=0;}
+ void close() {if (isOpen()) ::close(fd); fd=-1;}
+ bool open(const char*path, uint64_t&size) {
+  fd=::open(path,O_RDONLY);
+  struct stat st;
+  if (!isOpen() || fstat(fd,&st)) return false;
+  size=uint64_t(st.st_size);
+  return true;
+ }
+ bool read(uint64_t offset, void*p, size_t bytes) {
+  for (char*q=(char*)p; bytes; ) {
+   ssize_t got=pread(fd,q,bytes,off_t(offset));
+   if (got<=0) return false;
+   q+=got; offset+=uint64_t(got); bytes-=size_t(got);
+  }
+  return true;
+ }
+#endif
+ ~Store() {close();}
+	// Chunk "index", read unless kept; under lock
+ const vector<float_t>&page(size_t index) {
+  auto w=where.find(index);
+  if (w!=where.end()) {
+   if (w->second!=lru.begin()) lru.splice(lru.begin(),lru,w->second);
+   return lru.front().v;
+  }
+  if (lru.size()<pages) lru.push_front(Page());
+  else{					// drop the least recently used
+   lru.splice(lru.begin(),lru,std::prev(lru.end()));
+   where.erase(lru.front().index);
+  }
+  Page&g=lru.front();
+  g.index=index;
+  where[index]=lru.begin();
+  uint64_t first=uint64_t(index)*chunk;
+  size_t m=size_t(min(uint64_t(chunk),count-first));
+  g.v.resize(m);
+  reads++;
+  uint64_t at=sizeof(PlotFileHeader)+first*es;
+  bool ok;
+  if (es==sizeof(float_t)) ok=read(at,g.v.data(),m*es);
+  else{					// convert
+   vector<unsigned char> raw(m*es);
+   ok=read(at,raw.data(),raw.size());
+   for (size_t i=0; ok && i<m; i++) {
+    if (es==4) {float v; memcpy(&v,&raw[4*i],4); g.v[i]=v;}
+    else {double v; memcpy(&v,&raw[8*i],8); g.v[i]=float_t(v);}
+   }
+  }
+  if (!ok) fill(g.v.begin(),g.v.end(),NOPLOT);	// a read error: nothing to plot
+  return g.v;
+ }
+};
+
+Plotchunks::Plotchunks(size_t budget, size_t chunk):s(new Store),n(0) {
+ s->chunk=chunk ? chunk : size_t(1)<<20;
+ s->pages=max(budget/(s->chunk*sizeof(float_t)),size_t(2));
+}
+
+Plotchunks::~Plotchunks() {}
+
+bool Plotchunks::open(const char*path) {
+ close();
+ uint64_t size;
+ PlotFileHeader&h=s->h;
+ if (!s->open(path,size) || size<sizeof h || !s->read(0,&h,sizeof h)
+  || memcmp(h.magic,magic,sizeof magic) || h.version!=PlotFileHeader::VERSION
+  || h.order!=PlotFileHeader::ORDER) {close(); return false;}
+ s->es=h.type==PlotFileHeader::FLOAT32 ? 4 : h.type==PlotFileHeader::FLOAT64 ? 8 : 0;
+ if (!s->es || h.count>(size-sizeof h)/s->es || h.count>uint64_t(size_t(-1))) {close(); return false;}
+ s->count=h.count;
+ n=size_t(h.count);
+ return true;
+}
+
+void Plotchunks::close() {
+ std::lock_guard<std::mutex> g(s->lock);
+ s->close();
+ s->lru.clear();
+ s->where.clear();
+ s->count=0;
+ n=0;
+}
+
+bool Plotchunks::range(Plotdata::Range&r, uint64_t&nonfinite) const{
+ if (!n || !(s->h.flags&PlotFileHeader::RANGE)) return false;
+ r.init(float_t(s->h.min),float_t(s->h.max));
+ nonfinite=s->h.nonfinite;
+ return true;
+}
+
+float_t Plotchunks::operator[](size_t i) const{
+ std::lock_guard<std::mutex> g(s->lock);
+ return s->page(i/s->chunk)[i%s->chunk];
+}
+
+const float_t*Plotchunks::block(size_t i0, size_t m, float_t*buf) const{
+ std::lock_guard<std::mutex> g(s->lock);
+ for (size_t k=0; k<m; ) {
+  size_t i=i0+k, at=i%s->chunk;
+  const vector<float_t>&v=s->page(i/s->chunk);
+  size_t c=min(m-k,v.size()-at);
+  copy(v.begin()+at,v.begin()+at+c,buf+k);
+  k+=c;
+ }
+ return buf;
+}
+
+size_t Plotchunks::resident() const{
+ std::lock_guard<std::mutex> g(s->lock);
+ size_t b=0;
+ for (auto p=s->lru.begin(); p!=s->lru.end(); ++p) b+=p->v.capacity()*sizeof(float_t);
+ return b;
+}
+
+uint64_t Plotchunks::reads() const{
+ std::lock_guard<std::mutex> g(s->lock);
+ return s->reads;
+}
+
+// The header is written last, with the count and range of the elements
+Plotchunks::Writer::Writer(const char*path):f(fopen(path,"wb")),count(0),bad(0) {
+ r.init();
+ PlotFileHeader h;
+ memset(&h,0,sizeof h);
+ if (f && fwrite(&h,sizeof h,1,(FILE*)f)!=1) {fclose((FILE*)f); f=0;}
+ buf.reserve(1<<16);
+}
+
+Plotchunks::Writer::~Writer() {
+ if (f) fclose((FILE*)f);
+}
+
+void Plotchunks::Writer::write(const float_t*p, size_t m) {
+ buf.insert(buf.end(),p,p+m);
+ if (buf.size()>=1<<16) flush();
+}
+
+void Plotchunks::Writer::flush() {
+ float_t q[4];
+ size_t good=plotKernelRange(buf.data(),0,buf.size(),q);
+ if (good) r.expand(q[0],q[1]);
+ bad+=buf.size()-good;
+ count+=buf.size();
+ if (f && fwrite(buf.data(),sizeof(float_t),buf.size(),(FILE*)f)!=buf.size()) {fclose((FILE*)f); f=0;}
+ buf.clear();
+}
+
+bool Plotchunks::Writer::finish() {
+ flush();
+ if (!f) return false;
+ PlotFileHeader h;
+ memset(&h,0,sizeof h);
+ memcpy(h.magic,magic,sizeof magic);
+ h.version=PlotFileHeader::VERSION;
+ h.order=PlotFileHeader::ORDER;
+ h.type=nativeType;
+ h.count=count;
+ h.flags=PlotFileHeader::RANGE;
+ h.min=r.min;
+ h.max=r.max;
+ h.nonfinite=bad;
+ FILE*file=(FILE*)f;
+ f=0;
+ bool ok=!fseek(file,0,SEEK_SET) && fwrite(&h,sizeof h,1,file)==1;
+ return !fclose(file) && ok;
+}
@@ -0,0 +1,109 @@
+/* File: plotgdi.cpp
+ *
+ * Implementation class PlotGdi
+ * A PlotCanvas drawing on a Windows device context (see PlotGdi.h).
+ */
+#include "PlotGdi.h"
+
+#ifdef _WIN32
+
+#include <cstring>
+#include <windowsx.h>
+
+PlotGdi::PlotGdi(HDC d, HWND wnd)
+:dc(d),bitmap(0),font(0) {
+ GetClientRect(wnd,&rc);
+ open=SelectPen(dc,GetStockPen(BLACK_PEN));
+}
+
+PlotGdi::PlotGdi(HDC d, int width, int height)
+:dc(CreateCompatibleDC(d)),font(0) {
+ SetRect(&rc,0,0,width,height);
+ bitmap=CreateCompatibleBitmap(d,width,height);
+ obitmap=SelectBitmap(dc,bitmap);
+ FillRect(dc,&rc,GetSysColorBrush(COLOR_WINDOW));	// as the window class
+ open=SelectPen(dc,GetStockPen(BLACK_PEN));
+}
+
+PlotGdi::~PlotGdi() {
+ if (font) {
+  SetBkMode(dc,obkmode);
+  SelectFont(dc,ofont);
+  DeleteFont(font);
+ }
+ SelectPen(dc,open);
+ for (size_t i=0; i<pens.size(); i++) DeletePen(pens[i].h);
+ if (bitmap) {
+  SelectBitmap(dc,obitmap);
+  DeleteBitmap(bitmap);
+  DeleteDC(dc);
+ }
+}
+
+int PlotGdi::width() const {return rc.right-rc.left;}
+int PlotGdi::height() const {return rc.bottom-rc.top;}
+
+void PlotGdi::useFont() {
+ if (font) return;
+ font=CreateFont(16,0,0,0,0,0,0,0,0,0,0,0,0,"Arial");
+ ofont=SelectFont(dc,font);
+ obkmode=SetBkMode(dc,TRANSPARENT);
+}
+
+void PlotGdi::erase(Color colour) {
+ HBRUSH br=CreateSolidBrush(colour);
+ FillRect(dc,&rc,br);
+ DeleteBrush(br);
+}
+
+void PlotGdi::pen(Color colour, int width, PenStyle style) {
+ if (style==DOT) width=0;
+ size_t i=0;
+ while (i<pens.size() && (pens[i].colour!=colour || pens[i].width!=width || pens[i].style!=style)) i++;
+ if (i==pens.size()) {
+  Pen p={colour,width,style,CreatePen(style==DOT ? PS_DOT : PS_SOLID,width,colour)};
+  pens.push_back(p);
+ }
+ SelectPen(dc,pens[i].h);
+}
+
+void PlotGdi::rectangle(int l, int t, int r, int b, Color fill) {
+ HBRUSH br=CreateSolidBrush(fill);
+ HBRUSH obr=SelectBrush(dc,br);
+ Rectangle(dc,l,t,r,b);
+ SelectBrush(dc,obr);
+ DeleteBrush(br);
+}
+
+void PlotGdi::text(int x, int y, const char*s, TextAlign align, Color colour) {
+ static const UINT ta[]={TA_LEFT,TA_CENTER,TA_RIGHT};
+ useFont();
+ SetTextColor(dc,colour);
+ SetTextAlign(dc,ta[align]|TA_TOP);
+ TextOut(dc,x,y,s,int(strlen(s)));
+}
+
+void PlotGdi::textSize(const char*s, int&cx, int&cy) {
+ SIZE sz;
+ useFont();
+ GetTextExtentPoint32(dc,s,int(strlen(s)),&sz);
+ cx=sz.cx;
+ cy=sz.cy;
+}
+
+void PlotGdi::clip(int l, int t, int r, int b) {
+ SelectClipRgn(dc,0);
+ IntersectClipRect(dc,l,t,r,b);
+}
+
+PlotCanvas*PlotGdi::layer() const {
+ return new PlotGdi(dc,width(),height());
+}
+
+bool PlotGdi::copy(const PlotCanvas&layer) {
+ const PlotGdi*l=dynamic_cast<const PlotGdi*>(&layer);
+ if (!l || !l->bitmap || l->width()!=width() || l->height()!=height()) return false;
+ return BitBlt(dc,rc.left,rc.top,width(),height(),l->dc,0,0,SRCCOPY)!=FALSE;
+}
+
+#endif
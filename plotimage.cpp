@@ -0,0 +1,353 @@
+/* File: plotimage.cpp
+ *
+ * PPM and PNG writers for PlotRaster images (see PlotImage.h).
+ *
+ * The PNG encoder has its own deflate: LZ77 on hash chains, fixed
+ * Huffman codes. Plots are mostly flat colour, which filtering turns
+ * into long runs of zeros and LZ77 into few long matches; dynamic
+ * Huffman codes would gain little there.
+ *
+ * Each stripe of rows is deflated into blocks that end with an empty
+ * stored block (a "sync flush"), which leaves the output on a byte
+ * boundary with no reference to later data; so the deflated stripes
+ * can be concatenated into one stream. Only the last one has the final
+ * block flag. The Adler-32 checksum of the zlib stream is combined
+ * from those of the stripes.
+ */
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include "PlotImage.h"
+#include "PlotThreads.h"
+
+/* -------------------------------------------------------- */
+// Checksums
+
+struct CrcTable{
+ uint32_t t[256];
+ CrcTable() {
+  for (uint32_t i=0; i<256; i++) {
+   uint32_t c=i;
+   for (int k=0; k<8; k++) c=c&1 ? 0xEDB88320^c>>1 : c>>1;
+   t[i]=c;
+  }
+ }
+};
+static const CrcTable crcTable;
+
+static uint32_t crc32(uint32_t crc, const unsigned char*p, size_t n) {
+ crc=~crc;
+ for (size_t i=0; i<n; i++) crc=crcTable.t[(crc^p[i])&0xFF]^crc>>8;
+ return ~crc;
+}
+
+static const uint32_t adlerBase=65521;
+
+static uint32_t adler32(const unsigned char*p, size_t n) {
+ uint32_t a=1, b=0;
+ while (n) {
+  size_t m=n<5552 ? n : 5552;	// largest block without overflow
+  n-=m;
+  for (; m; m--) {a+=*p++; b+=a;}
+  a%=adlerBase;
+  b%=adlerBase;
+ }
+ return b<<16|a;
+}
+
+// Adler-32 of the concatenation of two blocks, the second one n2 bytes long
+static uint32_t adlerCombine(uint32_t a1, uint32_t a2, size_t n2) {
+ uint32_t rem=uint32_t(n2%adlerBase);
+ uint32_t s1=a1&0xFFFF;
+ uint32_t s2=uint32_t(uint64_t(rem)*s1%adlerBase);
+ s1+=(a2&0xFFFF)+adlerBase-1;
+ s2+=(a1>>16)+(a2>>16)+adlerBase-rem;
+ if (s1>=adlerBase) s1-=adlerBase;
+ if (s1>=adlerBase) s1-=adlerBase;
+ if (s2>=2*adlerBase) s2-=2*adlerBase;
+ if (s2>=adlerBase) s2-=adlerBase;
+ return s2<<16|s1;
+}
+
+/* -------------------------------------------------------- */
+// Deflate with fixed Huffman codes (RFC 1951)
+
+static const int lenBase[29]={3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,
+  35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const int lenExtra[29]={0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const int distBase[30]={1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
+  257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const int distExtra[30]={0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+static const int window=32768, maxMatch=258, hashBits=15, maxChain=16;
+
+// Fixed code tables, bit-reversed to be written LSB first
+struct FixedCodes{
+ uint16_t lit[288];		// literal/length codes
+ uint8_t litBits[288];
+ uint8_t dist[30];		// distance codes, 5 bits
+ uint8_t lenCode[maxMatch+1];	// length 3..258 -> index into lenBase
+ FixedCodes() {
+  for (int v=0; v<288; v++) {
+   int code, bits;
+   if (v<144) {code=0x30+v; bits=8;}
+   else if (v<256) {code=0x190+v-144; bits=9;}
+   else if (v<280) {code=v-256; bits=7;}
+   else {code=0xC0+v-280; bits=8;}
+   lit[v]=uint16_t(reverse(code,bits));
+   litBits[v]=uint8_t(bits);
+  }
+  for (int d=0; d<30; d++) dist[d]=uint8_t(reverse(d,5));
+  for (int l=3, c=0; l<=maxMatch; l++) {
+   while (c<28 && lenBase[c+1]<=l) c++;
+   lenCode[l]=uint8_t(c);
+  }
+ }
+ static int reverse(int code, int bits) {
+  int r=0;
+  for (int i=0; i<bits; i++) r|=(code>>i&1)<<(bits-1-i);
+  return r;
+ }
+};
+static const FixedCodes codes;
+
+// Deflater of one stripe, with buffers kept for the next image
+struct Stripe{
+ std::vector<unsigned char> in;	// filtered rows
+ std::vector<unsigned char> out;	// deflated
+ std::vector<int32_t> head, prev;	// hash chains
+ uint32_t adler;
+ uint64_t bitBuf;
+ int bitCount;
+
+ void put(uint32_t bits, int n) {
+  bitBuf|=uint64_t(bits)<<bitCount;
+  bitCount+=n;
+  while (bitCount>=8) {
+   out.push_back((unsigned char)bitBuf);
+   bitBuf>>=8;
+   bitCount-=8;
+  }
+ }
+ void literal(int v) {put(codes.lit[v],codes.litBits[v]);}
+ void match(int len, int dist) {
+  int c=codes.lenCode[len];
+  literal(257+c);
+  put(len-lenBase[c],lenExtra[c]);
+  int lo=0, hi=29;		// last distBase <= dist
+  while (lo<hi) {int m=(lo+hi+1)/2; if (distBase[m]<=dist) lo=m; else hi=m-1;}
+  put(codes.dist[lo],5);
+  put(dist-distBase[lo],distExtra[lo]);
+ }
+ static unsigned hash(const unsigned char*p) {
+  return (p[0]<<10^p[1]<<5^p[2])&((1<<hashBits)-1);
+ }
+ void deflate(bool last);
+};
+
+void Stripe::deflate(bool last) {
+ const unsigned char*p=in.data();
+ int n=int(in.size());
+ adler=adler32(p,n);
+ out.clear();
+ bitBuf=0;
+ bitCount=0;
+ head.assign(1<<hashBits,-1);
+ prev.resize(window);
+ put(last ? 3 : 2,3);		// BFINAL, BTYPE=01 fixed codes
+ int i=0;
+ while (i<n) {
+  int best=0, dist=0;
+  if (i+3<=n) {
+   unsigned h=hash(p+i);
+   int cand=head[h], limit=n-i<maxMatch ? n-i : maxMatch;
+   prev[i&(window-1)]=cand;
+   head[h]=i;
+   for (int chain=maxChain; cand>=0 && i-cand<=window && chain; chain--) {
+    if (p[cand+best]==p[i+best]) {
+     int l=0;
+     while (l<limit && p[cand+l]==p[i+l]) l++;
+     if (l>best) {best=l; dist=i-cand; if (l==limit) break;}
+    }
+    int next=prev[cand&(window-1)];
+    if (next>=cand) break;	// slot reused by a newer position
+    cand=next;
+   }
+  }
+  if (best>=3) {
+   match(best,dist);
+   for (int k=i+1; k<i+best && k+3<=n; k++) {	// enter the skipped positions
+    unsigned h=hash(p+k);
+    prev[k&(window-1)]=head[h];
+    head[h]=k;
+   }
+   i+=best;
+  }else literal(p[i++]);
+ }
+ literal(256);			// end of block
+ if (!last) {			// sync flush: empty stored block
+  put(0,3);
+  if (bitCount) put(0,8-bitCount);
+  put(0x0000,16);
+  put(0xFFFF,16);
+ }else if (bitCount) put(0,8-bitCount);
+}
+
+/* -------------------------------------------------------- */
+// PNG
+
+// Filter one row of RGB bytes (PNG filters 0-4), choosing the filter
+// with the least sum of absolute differences, as libpng does.
+static void filterRow(const unsigned char*row, const unsigned char*up,
+                      size_t n, unsigned char*dst, unsigned char*tmp) {
+ const int bpp=3;
+ unsigned char*cand[5]={dst+1,tmp,tmp+n,tmp+2*n,tmp+3*n};
+ unsigned long sum[5]={0,0,0,0,0};
+ for (size_t i=0; i<n; i++) {
+  int a=i>=bpp ? row[i-bpp] : 0, b=up ? up[i] : 0, c=up && i>=bpp ? up[i-bpp] : 0;
+  int pa=abs(b-c), pb=abs(a-c), pc=abs(a+b-2*c);
+  int paeth=pa<=pb && pa<=pc ? a : pb<=pc ? b : c;
+  unsigned char v[5]={row[i],(unsigned char)(row[i]-a),(unsigned char)(row[i]-b),
+    (unsigned char)(row[i]-(a+b)/2),(unsigned char)(row[i]-paeth)};
+  for (int f=0; f<5; f++) {
+   cand[f][i]=v[f];
+   sum[f]+=v[f]<128 ? v[f] : 256-v[f];
+  }
+ }
+ int best=0;
+ for (int f=1; f<5; f++) if (sum[f]<sum[best]) best=f;
+ dst[0]=(unsigned char)best;
+ if (best) memcpy(dst+1,cand[best],n);
+}
+
+// Working buffers of one thread
+struct PngWork{
+ std::vector<Stripe> stripes;
+ std::vector<unsigned char> rgb;	// image as RGB rows
+ std::vector<unsigned char> png;	// file contents
+};
+
+static void chunk(std::vector<unsigned char>&png, const char*type,
+                  const unsigned char*data, size_t n) {
+ unsigned char len[4]={(unsigned char)(n>>24),(unsigned char)(n>>16),(unsigned char)(n>>8),(unsigned char)n};
+ png.insert(png.end(),len,len+4);
+ size_t start=png.size();
+ png.insert(png.end(),type,type+4);
+ png.insert(png.end(),data,data+n);
+ uint32_t crc=crc32(0,&png[start],png.size()-start);
+ unsigned char c[4]={(unsigned char)(crc>>24),(unsigned char)(crc>>16),(unsigned char)(crc>>8),(unsigned char)crc};
+ png.insert(png.end(),c,c+4);
+}
+
+static void put32(unsigned char*p, uint32_t v) {
+ p[0]=(unsigned char)(v>>24); p[1]=(unsigned char)(v>>16);
+ p[2]=(unsigned char)(v>>8); p[3]=(unsigned char)v;
+}
+
+// Rows per stripe at the least, so that LZ77 has something to work on
+static const int minStripeRows=16;
+
+static void encode(const PlotRaster&img, PngWork&w, std::vector<unsigned char>&png) {
+ int width=img.width(), height=img.height();
+ size_t rowBytes=size_t(width)*3;
+	// RGB rows
+ w.rgb.resize(rowBytes*height);
+ const uint32_t*px=img.pixels();
+ for (size_t i=0, n=size_t(width)*height; i<n; i++) {
+  w.rgb[3*i]=(unsigned char)px[i];
+  w.rgb[3*i+1]=(unsigned char)(px[i]>>8);
+  w.rgb[3*i+2]=(unsigned char)(px[i]>>16);
+ }
+	// filter and deflate stripes in parallel
+ unsigned parts=height ? plotParts(height,minStripeRows) : 1;
+ if (w.stripes.size()<parts) w.stripes.resize(parts);
+ const unsigned char*rgb=w.rgb.data();
+ plotParallel(parts,height,[&](unsigned k,size_t y0,size_t y1){
+  Stripe&s=w.stripes[k];
+  s.in.resize((y1-y0)*(rowBytes+1));
+  std::vector<unsigned char>&tmp=s.out;		// scratch until deflate()
+  tmp.resize(4*rowBytes);
+  for (size_t y=y0; y<y1; y++)
+   filterRow(rgb+y*rowBytes,y ? rgb+(y-1)*rowBytes : 0,rowBytes,
+     &s.in[(y-y0)*(rowBytes+1)],tmp.data());
+  s.deflate(k==parts-1);
+ });
+	// zlib stream
+ std::vector<unsigned char>&z=w.rgb;		// reuse, pixels are done
+ z.clear();
+ z.push_back(0x78);		// deflate, 32K window
+ z.push_back(0x01);		// fastest
+ uint32_t adler=1;
+ for (unsigned k=0; k<parts; k++) {
+  Stripe&s=w.stripes[k];
+  z.insert(z.end(),s.out.begin(),s.out.end());
+  adler=adlerCombine(adler,s.adler,s.in.size());
+ }
+ unsigned char a[4];
+ put32(a,adler);
+ z.insert(z.end(),a,a+4);
+	// file
+ static const unsigned char signature[8]={0x89,'P','N','G','\r','\n',0x1A,'\n'};
+ unsigned char ihdr[13]={0,0,0,0,0,0,0,0,8,2,0,0,0};	// 8 bit RGB
+ put32(ihdr,width);
+ put32(ihdr+4,height);
+ png.assign(signature,signature+8);
+ chunk(png,"IHDR",ihdr,13);
+ chunk(png,"IDAT",z.data(),z.size());
+ chunk(png,"IEND",0,0);
+}
+
+static PngWork&work() {
+ static thread_local PngWork w;
+ return w;
+}
+
+void plotEncodePng(const PlotRaster&img, std::vector<unsigned char>&png) {
+ encode(img,work(),png);
+}
+
+static bool write(const char*path, const void*p, size_t n) {
+ FILE*f=fopen(path,"wb");
+ if (!f) return false;
+ bool ok=fwrite(p,1,n,f)==n;
+ return fclose(f)==0 && ok;
+}
+
+bool plotSavePng(const PlotRaster&img, const char*path) {
+ PngWork&w=work();
+ encode(img,w,w.png);
+ return write(path,w.png.data(),w.png.size());
+}
+
+/* -------------------------------------------------------- */
+// PPM
+
+bool plotSavePpm(const PlotRaster&img, const char*path) {
+ PngWork&w=work();
+ char head[32];
+ int n=sprintf(head,"P6\n%d %d\n255\n",img.width(),img.height());
+ w.png.assign(head,head+n);
+ const uint32_t*px=img.pixels();
+ for (size_t i=0, m=size_t(img.width())*img.height(); i<m; i++) {
+  w.png.push_back((unsigned char)px[i]);
+  w.png.push_back((unsigned char)(px[i]>>8));
+  w.png.push_back((unsigned char)(px[i]>>16));
+ }
+ return write(path,w.png.data(),w.png.size());
+}
+
+bool plotSaveImage(const PlotRaster&img, const char*path) {
+ size_t n=strlen(path);
+ const char*ext=n>=4 ? path+n-4 : "";
+ bool ppm=false;
+ if (ext[0]=='.') {
+  char e[4];
+  for (int i=0; i<3; i++) e[i]=char(tolower((unsigned char)ext[i+1]));
+  e[3]=0;
+  ppm=!strcmp(e,"ppm") || !strcmp(e,"pnm");
+ }
+ return ppm ? plotSavePpm(img,path) : plotSavePng(img,path);
+}
@@ -0,0 +1,479 @@
+/* File: plotkernels.cpp
+ *
+ * Element-wise kernels behind the Plotdata arithmetic operators,
+ * with runtime selection of the instruction set (see PlotKernels.h).
+ *
+ * The loops themselves are in plotkernels.inl, the math functions in
+ * plotmath.inl; this file defines the register types of each instruction
+ * set and detects the processor.
+ * Code for AVX2 and AVX-512 is compiled for that target only, so the
+ * rest of the library does not require those instructions.
+ */
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+
+#include "PlotData.h"
+#include "PlotThreads.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+# define PLOT_X86
+# ifdef _MSC_VER
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+# include <immintrin.h>
+#endif
+
+/* -------------------------------------------------------- */
+// Register types of each instruction set
+//
+// Lanes<float> and Lanes<double> provide arithmetic (add ... neg, sqrt,
+// abs), min and max, and for range(): le giving an all-ones/all-zeros
+// mask, bitwise and/or/andnot, and count, the number of lanes set in a mask.
+// Lanes<double> also provides what plotmath.inl needs: more comparisons,
+// and shifts of the 64-bit patterns by 52 bits (the exponent field).
+// The SIMD namespaces only: the plain C++ range() is rangeScalar() below.
+
+// Plain C++: one element per "register"
+namespace scalar{
+template<class T> struct Lanes{
+ typedef T V;
+ enum{N=1};
+ static V load(const T*p) {return *p;}
+ static void store(T*p,V v) {*p=v;}
+ static V set1(T s) {return s;}
+ static V add(V a,V b) {return a+b;}
+ static V sub(V a,V b) {return a-b;}
+ static V mul(V a,V b) {return a*b;}
+ static V div(V a,V b) {return a/b;}
+ static V neg(V a) {return -a;}
+ static V sqrt(V a) {return std::sqrt(a);}
+ static V abs(V a) {return std::fabs(a);}
+	// Bit level operations, instantiated for double only
+ static uint64_t bits(V a) {uint64_t u; memcpy(&u,&a,sizeof u); return u;}
+ static V value(uint64_t u) {V a; memcpy(&a,&u,sizeof a); return a;}
+ static V mask(bool b) {return value(b ? ~uint64_t(0) : 0);}
+ static V lt(V a,V b) {return mask(a<b);}
+ static V le(V a,V b) {return mask(a<=b);}
+ static V eq(V a,V b) {return mask(a==b);}
+ static V band(V a,V b) {return value(bits(a)&bits(b));}
+ static V bor(V a,V b) {return value(bits(a)|bits(b));}
+ static V bandnot(V a,V b) {return value(~bits(a)&bits(b));}
+ static V shl52(V a) {return value(bits(a)<<52);}
+ static V shr52(V a) {return value(bits(a)>>52);}
+ static bool any(V m) {return bits(m)!=0;}
+};
+#include "plotmath.inl"
+#include "plotkernels.inl"
+}
+
+#ifdef PLOT_X86
+
+// Compile the following namespace for one instruction set only
+#if defined(__clang__)
+# define PLOT_TARGET_BEGIN(isa) _Pragma(isa)
+# define PLOT_TARGET_END _Pragma("clang attribute pop")
+# define PLOT_SSE2   "clang attribute push(__attribute__((target(\"sse2\"))),apply_to=function)"
+# define PLOT_AVX2   "clang attribute push(__attribute__((target(\"avx2\"))),apply_to=function)"
+# define PLOT_AVX512 "clang attribute push(__attribute__((target(\"avx512f\"))),apply_to=function)"
+#elif defined(__GNUC__)
+# define PLOT_TARGET_BEGIN(isa) _Pragma("GCC push_options") _Pragma(isa)
+# define PLOT_TARGET_END _Pragma("GCC pop_options")
+# define PLOT_SSE2   "GCC target(\"sse2\")"
+# define PLOT_AVX2   "GCC target(\"avx2\")"
+# define PLOT_AVX512 "GCC target(\"avx512f\")"
+#else	// MSVC: intrinsics are always available
+# define PLOT_TARGET_BEGIN(isa)
+# define PLOT_TARGET_END
+#endif
+
+// Number of bits set
+static inline int ones(unsigned b) {
+ int n=0;
+ for (; b; b&=b-1) n++;
+ return n;
+}
+
+PLOT_TARGET_BEGIN(PLOT_SSE2)
+namespace sse2{
+template<class T> struct Lanes;
+template<> struct Lanes<double>{
+ typedef __m128d V;
+ enum{N=2};
+ static V load(const double*p) {return _mm_loadu_pd(p);}
+ static void store(double*p,V v) {_mm_storeu_pd(p,v);}
+ static V set1(double s) {return _mm_set1_pd(s);}
+ static V add(V a,V b) {return _mm_add_pd(a,b);}
+ static V sub(V a,V b) {return _mm_sub_pd(a,b);}
+ static V mul(V a,V b) {return _mm_mul_pd(a,b);}
+ static V div(V a,V b) {return _mm_div_pd(a,b);}
+ static V neg(V a) {return _mm_xor_pd(a,_mm_set1_pd(-0.0));}
+ static V sqrt(V a) {return _mm_sqrt_pd(a);}
+ static V abs(V a) {return _mm_andnot_pd(_mm_set1_pd(-0.0),a);}
+ static V min(V a,V b) {return _mm_min_pd(a,b);}
+ static V max(V a,V b) {return _mm_max_pd(a,b);}
+ static V lt(V a,V b) {return _mm_cmplt_pd(a,b);}
+ static V le(V a,V b) {return _mm_cmple_pd(a,b);}
+ static V eq(V a,V b) {return _mm_cmpeq_pd(a,b);}
+ static V band(V a,V b) {return _mm_and_pd(a,b);}
+ static V bor(V a,V b) {return _mm_or_pd(a,b);}
+ static V bandnot(V a,V b) {return _mm_andnot_pd(a,b);}
+ static V shl52(V a) {return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a),52));}
+ static V shr52(V a) {return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a),52));}
+ static bool any(V m) {return _mm_movemask_pd(m)!=0;}
+ static int count(V m) {return ones(_mm_movemask_pd(m));}
+};
+template<> struct Lanes<float>{
+ typedef __m128 V;
+ enum{N=4};
+ static V load(const float*p) {return _mm_loadu_ps(p);}
+ static void store(float*p,V v) {_mm_storeu_ps(p,v);}
+ static V set1(float s) {return _mm_set1_ps(s);}
+ static V add(V a,V b) {return _mm_add_ps(a,b);}
+ static V sub(V a,V b) {return _mm_sub_ps(a,b);}
+ static V mul(V a,V b) {return _mm_mul_ps(a,b);}
+ static V div(V a,V b) {return _mm_div_ps(a,b);}
+ static V neg(V a) {return _mm_xor_ps(a,_mm_set1_ps(-0.0f));}
+ static V sqrt(V a) {return _mm_sqrt_ps(a);}
+ static V abs(V a) {return _mm_andnot_ps(_mm_set1_ps(-0.0f),a);}
+ static V min(V a,V b) {return _mm_min_ps(a,b);}
+ static V max(V a,V b) {return _mm_max_ps(a,b);}
+ static V le(V a,V b) {return _mm_cmple_ps(a,b);}
+ static V band(V a,V b) {return _mm_and_ps(a,b);}
+ static V bor(V a,V b) {return _mm_or_ps(a,b);}
+ static V bandnot(V a,V b) {return _mm_andnot_ps(a,b);}
+ static int count(V m) {return ones(_mm_movemask_ps(m));}
+};
+#include "plotmath.inl"
+#include "plotkernels.inl"
+}
+PLOT_TARGET_END
+
+PLOT_TARGET_BEGIN(PLOT_AVX2)
+namespace avx2{
+template<class T> struct Lanes;
+template<> struct Lanes<double>{
+ typedef __m256d V;
+ enum{N=4};
+ static V load(const double*p) {return _mm256_loadu_pd(p);}
+ static void store(double*p,V v) {_mm256_storeu_pd(p,v);}
+ static V set1(double s) {return _mm256_set1_pd(s);}
+ static V add(V a,V b) {return _mm256_add_pd(a,b);}
+ static V sub(V a,V b) {return _mm256_sub_pd(a,b);}
+ static V mul(V a,V b) {return _mm256_mul_pd(a,b);}
+ static V div(V a,V b) {return _mm256_div_pd(a,b);}
+ static V neg(V a) {return _mm256_xor_pd(a,_mm256_set1_pd(-0.0));}
+ static V sqrt(V a) {return _mm256_sqrt_pd(a);}
+ static V abs(V a) {return _mm256_andnot_pd(_mm256_set1_pd(-0.0),a);}
+ static V min(V a,V b) {return _mm256_min_pd(a,b);}
+ static V max(V a,V b) {return _mm256_max_pd(a,b);}
+ static V lt(V a,V b) {return _mm256_cmp_pd(a,b,_CMP_LT_OQ);}
+ static V le(V a,V b) {return _mm256_cmp_pd(a,b,_CMP_LE_OQ);}
+ static V eq(V a,V b) {return _mm256_cmp_pd(a,b,_CMP_EQ_OQ);}
+ static V band(V a,V b) {return _mm256_and_pd(a,b);}
+ static V bor(V a,V b) {return _mm256_or_pd(a,b);}
+ static V bandnot(V a,V b) {return _mm256_andnot_pd(a,b);}
+ static V shl52(V a) {return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a),52));}
+ static V shr52(V a) {return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a),52));}
+ static bool any(V m) {return _mm256_movemask_pd(m)!=0;}
+ static int count(V m) {return ones(_mm256_movemask_pd(m));}
+};
+template<> struct Lanes<float>{
+ typedef __m256 V;
+ enum{N=8};
+ static V load(const float*p) {return _mm256_loadu_ps(p);}
+ static void store(float*p,V v) {_mm256_storeu_ps(p,v);}
+ static V set1(float s) {return _mm256_set1_ps(s);}
+ static V add(V a,V b) {return _mm256_add_ps(a,b);}
+ static V sub(V a,V b) {return _mm256_sub_ps(a,b);}
+ static V mul(V a,V b) {return _mm256_mul_ps(a,b);}
+ static V div(V a,V b) {return _mm256_div_ps(a,b);}
+ static V neg(V a) {return _mm256_xor_ps(a,_mm256_set1_ps(-0.0f));}
+ static V sqrt(V a) {return _mm256_sqrt_ps(a);}
+ static V abs(V a) {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f),a);}
+ static V min(V a,V b) {return _mm256_min_ps(a,b);}
+ static V max(V a,V b) {return _mm256_max_ps(a,b);}
+ static V le(V a,V b) {return _mm256_cmp_ps(a,b,_CMP_LE_OQ);}
+ static V band(V a,V b) {return _mm256_and_ps(a,b);}
+ static V bor(V a,V b) {return _mm256_or_ps(a,b);}
+ static V bandnot(V a,V b) {return _mm256_andnot_ps(a,b);}
+ static int count(V m) {return ones(_mm256_movemask_ps(m));}
+};
+#include "plotmath.inl"
+#include "plotkernels.inl"
+}
+PLOT_TARGET_END
+
+PLOT_TARGET_BEGIN(PLOT_AVX512)
+namespace avx512{
+template<class T> struct Lanes;
+template<> struct Lanes<double>{
+ typedef __m512d V;
+ enum{N=8};
+	// bitwise operations on doubles need AVX512DQ, do them on integers (AVX512F)
+ static __m512i i(V a) {return _mm512_castpd_si512(a);}
+ static V d(__m512i a) {return _mm512_castsi512_pd(a);}
+ static V m(__mmask8 k) {return d(_mm512_maskz_set1_epi64(k,-1));}
+ static V load(const double*p) {return _mm512_loadu_pd(p);}
+ static void store(double*p,V v) {_mm512_storeu_pd(p,v);}
+ static V set1(double s) {return _mm512_set1_pd(s);}
+ static V add(V a,V b) {return _mm512_add_pd(a,b);}
+ static V sub(V a,V b) {return _mm512_sub_pd(a,b);}
+ static V mul(V a,V b) {return _mm512_mul_pd(a,b);}
+ static V div(V a,V b) {return _mm512_div_pd(a,b);}
+ static V neg(V a) {return d(_mm512_xor_si512(i(a),_mm512_set1_epi64((long long)0x8000000000000000ULL)));}
+ static V sqrt(V a) {return _mm512_sqrt_pd(a);}
+ static V abs(V a) {return d(_mm512_and_si512(i(a),_mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL)));}
+ static V min(V a,V b) {return _mm512_min_pd(a,b);}
+ static V max(V a,V b) {return _mm512_max_pd(a,b);}
+ static V lt(V a,V b) {return m(_mm512_cmp_pd_mask(a,b,_CMP_LT_OQ));}
+ static V le(V a,V b) {return m(_mm512_cmp_pd_mask(a,b,_CMP_LE_OQ));}
+ static V eq(V a,V b) {return m(_mm512_cmp_pd_mask(a,b,_CMP_EQ_OQ));}
+ static V band(V a,V b) {return d(_mm512_and_si512(i(a),i(b)));}
+ static V bor(V a,V b) {return d(_mm512_or_si512(i(a),i(b)));}
+ static V bandnot(V a,V b) {return d(_mm512_andnot_si512(i(a),i(b)));}
+ static V shl52(V a) {return d(_mm512_slli_epi64(i(a),52));}
+ static V shr52(V a) {return d(_mm512_srli_epi64(i(a),52));}
+ static bool any(V a) {return _mm512_test_epi64_mask(i(a),i(a))!=0;}
+ static int count(V a) {return ones(_mm512_test_epi64_mask(i(a),i(a)));}
+};
+template<> struct Lanes<float>{
+ typedef __m512 V;
+ enum{N=16};
+ static __m512i i(V a) {return _mm512_castps_si512(a);}
+ static V f(__m512i a) {return _mm512_castsi512_ps(a);}
+ static V load(const float*p) {return _mm512_loadu_ps(p);}
+ static void store(float*p,V v) {_mm512_storeu_ps(p,v);}
+ static V set1(float s) {return _mm512_set1_ps(s);}
+ static V add(V a,V b) {return _mm512_add_ps(a,b);}
+ static V sub(V a,V b) {return _mm512_sub_ps(a,b);}
+ static V mul(V a,V b) {return _mm512_mul_ps(a,b);}
+ static V div(V a,V b) {return _mm512_div_ps(a,b);}
+ static V neg(V a) {return f(_mm512_xor_si512(i(a),_mm512_set1_epi32((int)0x80000000U)));}
+ static V sqrt(V a) {return _mm512_sqrt_ps(a);}
+ static V abs(V a) {return f(_mm512_and_si512(i(a),_mm512_set1_epi32(0x7FFFFFFF)));}
+ static V min(V a,V b) {return _mm512_min_ps(a,b);}
+ static V max(V a,V b) {return _mm512_max_ps(a,b);}
+ static V le(V a,V b) {return f(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a,b,_CMP_LE_OQ),-1));}
+ static V band(V a,V b) {return f(_mm512_and_si512(i(a),i(b)));}
+ static V bor(V a,V b) {return f(_mm512_or_si512(i(a),i(b)));}
+ static V bandnot(V a,V b) {return f(_mm512_andnot_si512(i(a),i(b)));}
+ static int count(V a) {return ones(_mm512_test_epi32_mask(i(a),i(a)));}
+};
+#include "plotmath.inl"
+#include "plotkernels.inl"
+}
+PLOT_TARGET_END
+
+/* -------------------------------------------------------- */
+// Processor detection
+
+static void cpuid(unsigned leaf,unsigned sub,unsigned r[4]) {
+#ifdef _MSC_VER
+ __cpuidex((int*)r,leaf,sub);
+#else
+ r[0]=r[1]=r[2]=r[3]=0;
+ __get_cpuid_count(leaf,sub,r,r+1,r+2,r+3);
+#endif
+}
+
+// Register state enabled by the OS (XCR0)
+static unsigned long long xcr0() {
+#ifdef _MSC_VER
+ return _xgetbv(0);
+#else
+ unsigned lo,hi;
+ __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+ return (unsigned long long)hi<<32 | lo;
+#endif
+}
+
+static PlotIsa detect() {
+ unsigned r[4];
+ cpuid(0,0,r);
+ unsigned maxLeaf=r[0];
+ if (maxLeaf<1) return ISA_SCALAR;
+ cpuid(1,0,r);
+ if (!(r[3]>>26&1)) return ISA_SCALAR;		// SSE2
+ bool osxsave=r[2]>>27&1, avx=r[2]>>28&1;
+ if (!osxsave || !avx || maxLeaf<7) return ISA_SSE2;
+ unsigned long long xcr=xcr0();
+ if ((xcr&0x06)!=0x06) return ISA_SSE2;	// XMM and YMM state
+ cpuid(7,0,r);
+ if (!(r[1]>>5&1)) return ISA_SSE2;		// AVX2
+ if (!(r[1]>>16&1) || (xcr&0xE6)!=0xE6) return ISA_AVX2;	// AVX-512F, opmask and ZMM state
+ return ISA_AVX512;
+}
+
+#else	// not x86
+
+static PlotIsa detect() {return ISA_SCALAR;}
+
+#endif
+
+/* -------------------------------------------------------- */
+// Kernel table for float_t
+
+typedef bool (*KernelVV)(int,const float_t*,const float_t*,float_t*,size_t);
+typedef bool (*KernelVS)(int,const float_t*,float_t,float_t*,size_t);
+typedef bool (*KernelSV)(int,float_t,const float_t*,float_t*,size_t);
+typedef bool (*KernelV)(int,const float_t*,float_t*,size_t);
+typedef size_t (*KernelRange)(const float_t*,const float_t*,size_t,float_t*);
+
+struct Kernels{
+ KernelVV vv;
+ KernelVS vs;
+ KernelSV sv;
+ KernelV v;
+ KernelRange range;
+};
+
+// range() in plain C++, the loop formerly in Plotdata::rangeXY
+template<class T> static size_t rangeScalar(const T*x,const T*y,size_t n,T r[4]) {
+ size_t count=0;
+ for (size_t i=0; i<n; i++) {
+  if (!isfinite(x[i]) || (y && !isfinite(y[i]))) continue;
+  if (r[0]>x[i]) r[0]=x[i];
+  if (r[1]<x[i]) r[1]=x[i];
+  if (y) {
+   if (r[2]>y[i]) r[2]=y[i];
+   if (r[3]<y[i]) r[3]=y[i];
+  }
+  count++;
+ }
+ return count;
+}
+
+// SIMD registers exist for float and double only; any other float_t
+// (long double on x87 builds) always uses the plain C++ loops.
+template<class T,bool simd=(is_same<T,float>::value || is_same<T,double>::value)>
+struct Tables{
+ static Kernels get(PlotIsa isa) {
+  Kernels k={scalar::vv<T>,scalar::vs<T>,scalar::sv<T>,scalar::v<T>,rangeScalar<T>};
+#ifdef PLOT_X86
+  switch (isa) {
+   case ISA_SSE2: {Kernels s={sse2::vv<T>,sse2::vs<T>,sse2::sv<T>,sse2::v<T>,sse2::range<T>}; k=s;}break;
+   case ISA_AVX2: {Kernels s={avx2::vv<T>,avx2::vs<T>,avx2::sv<T>,avx2::v<T>,avx2::range<T>}; k=s;}break;
+   case ISA_AVX512: {Kernels s={avx512::vv<T>,avx512::vs<T>,avx512::sv<T>,avx512::v<T>,avx512::range<T>}; k=s;}break;
+   default: break;
+  }
+#endif
+  return k;
+ }
+};
+template<class T> struct Tables<T,false>{
+ static Kernels get(PlotIsa) {
+  Kernels k={scalar::vv<T>,scalar::vs<T>,scalar::sv<T>,scalar::v<T>,rangeScalar<T>};
+  return k;
+ }
+};
+
+// Selected on first use, so that static Plotdata objects can be computed
+// before this file is initialized.
+static PlotIsa detected() {
+ static PlotIsa isa=detect();
+ return isa;
+}
+static PlotIsa current=ISA_SCALAR;
+static Kernels&kernels() {
+ static Kernels k=Tables<float_t>::get(current=detected());
+ return k;
+}
+
+PlotIsa plotIsaDetected() {return detected();}
+
+PlotIsa plotIsa() {kernels(); return current;}
+
+PlotIsa plotSetIsa(PlotIsa isa) {
+ if (isa>detected()) isa=detected();
+ kernels()=Tables<float_t>::get(isa);
+ return current=isa;
+}
+
+const char*plotIsaName(PlotIsa isa) {
+ static const char*names[]={"scalar","SSE2","AVX2","AVX-512"};
+ return names[isa];
+}
+
+bool plotKernelVV(int op,const float_t*a,const float_t*b,float_t*o,size_t n) {
+ return kernels().vv(op,a,b,o,n);
+}
+
+bool plotKernelVS(int op,const float_t*a,float_t s,float_t*o,size_t n) {
+ return kernels().vs(op,a,s,o,n);
+}
+
+bool plotKernelSV(int op,float_t s,const float_t*b,float_t*o,size_t n) {
+ return kernels().sv(op,s,b,o,n);
+}
+
+bool plotKernelV(int op,const float_t*a,float_t*o,size_t n) {
+ return kernels().v(op,a,o,n);
+}
+
+// Split across threads above this many elements per thread
+static const size_t rangePart=1<<18;
+
+// Range of a part of strided x and y, gathered into blocks for the kernel
+static size_t rangeGather(KernelRange range,const char*x,size_t xs,const char*y,size_t ys,
+                          size_t n,float_t r[4]) {
+ const size_t block=1024;
+ float_t bx[block],by[block];
+ size_t count=0;
+ for (size_t i=0; i<n; i+=block) {
+  size_t m=n-i<block ? n-i : block;
+  for (size_t j=0; j<m; j++) bx[j]=*(const float_t*)(x+(i+j)*xs);
+  if (y) for (size_t j=0; j<m; j++) by[j]=*(const float_t*)(y+(i+j)*ys);
+  count+=range(bx,y ? by : 0,m,r);
+ }
+ return count;
+}
+
+size_t plotKernelRange(const float_t*x,size_t xs,const float_t*y,size_t ys,size_t n,float_t r[4]) {
+ const float_t inf=numeric_limits<float_t>::infinity();
+ const char*bx=(const char*)x,*by=(const char*)y;
+ bool contiguous=xs==sizeof(float_t) && (!y || ys==sizeof(float_t));
+ r[0]=r[2]=inf;
+ r[1]=r[3]=-inf;
+ KernelRange range=kernels().range;
+ unsigned parts=plotParts(n,rangePart);
+ size_t count=0;
+ if (parts<=1) count=contiguous ? range(x,y,n,r) : rangeGather(range,bx,xs,by,ys,n,r);
+ else{
+  struct Part{float_t r[4]; size_t count;};
+  vector<Part> part(parts);
+  plotParallel(parts,n,[&](unsigned k,size_t i0,size_t i1){
+   Part&p=part[k];
+   p.r[0]=p.r[2]=inf;
+   p.r[1]=p.r[3]=-inf;
+   p.count=contiguous ? range(x+i0,y ? y+i0 : 0,i1-i0,p.r)
+     : rangeGather(range,bx+i0*xs,xs,y ? by+i0*ys : 0,ys,i1-i0,p.r);
+  });
+  for (unsigned k=0; k<parts; k++) {
+   if (r[0]>part[k].r[0]) r[0]=part[k].r[0];
+   if (r[1]<part[k].r[1]) r[1]=part[k].r[1];
+   if (r[2]>part[k].r[2]) r[2]=part[k].r[2];
+   if (r[3]<part[k].r[3]) r[3]=part[k].r[3];
+   count+=part[k].count;
+  }
+ }
+	// Reductions in any order give the same value, except that min/max
+	// may pick -0 or +0 among equal zeros: take the first one, as the
+	// plain loop does.
+ for (int j=0; j<(y ? 4 : 2); j++) if (count && r[j]==0) {
+  for (size_t i=0; i<n; i++) {
+   float_t xi=*(const float_t*)(bx+i*xs), yi=y ? *(const float_t*)(by+i*ys) : 0;
+   float_t a=j<2 ? xi : yi;
+   if (a==0 && isfinite(xi) && isfinite(yi)) {r[j]=a; break;}
+  }
+ }
+ return count;
+}
+
+size_t plotKernelRange(const float_t*x,const float_t*y,size_t n,float_t r[4]) {
+ return plotKernelRange(x,sizeof(float_t),y,sizeof(float_t),n,r);
+}
@@ -0,0 +1,221 @@
+/* File: plotkernels.inl
+ *
+ * Kernel loops, written once for all instruction sets.
+ *
+ * Included by plotkernels.cpp inside the namespace of each instruction
+ * set, after that namespace has defined Lanes<T>:
+ *	typedef ... V;		one register of T
+ *	enum{N=...};		elements per register
+ *	load, store, set1, add, sub, mul, div, neg, sqrt, abs
+ *	and, for range() only, min, max, le, band, bor, bandnot, count
+ * and after plotmath.inl.
+ */
+
+// Operations on a register (v) and on a single element (s)
+struct Add{
+ template<class L> static typename L::V v(typename L::V a,typename L::V b) {return L::add(a,b);}
+ template<class T> static T s(T a,T b) {return a+b;}
+};
+struct Sub{
+ template<class L> static typename L::V v(typename L::V a,typename L::V b) {return L::sub(a,b);}
+ template<class T> static T s(T a,T b) {return a-b;}
+};
+struct Mul{
+ template<class L> static typename L::V v(typename L::V a,typename L::V b) {return L::mul(a,b);}
+ template<class T> static T s(T a,T b) {return a*b;}
+};
+struct Div{
+ template<class L> static typename L::V v(typename L::V a,typename L::V b) {return L::div(a,b);}
+ template<class T> static T s(T a,T b) {return a/b;}
+};
+
+struct Neg{template<class L> static typename L::V v(typename L::V a) {return L::neg(a);}};
+struct Sqrt{template<class L> static typename L::V v(typename L::V a) {return L::sqrt(a);}};
+struct Abs{template<class L> static typename L::V v(typename L::V a) {return L::abs(a);}};
+
+template<class T,class Op> static void loopVV(const T*a,const T*b,T*o,size_t n) {
+ typedef Lanes<T> L;
+ size_t i=0;
+ for (; i+L::N<=n; i+=L::N) L::store(o+i,Op::template v<L>(L::load(a+i),L::load(b+i)));
+ for (; i<n; i++) o[i]=Op::s(a[i],b[i]);
+}
+
+template<class T,class Op> static void loopVS(const T*a,T s,T*o,size_t n) {
+ typedef Lanes<T> L;
+ typename L::V vs=L::set1(s);
+ size_t i=0;
+ for (; i+L::N<=n; i+=L::N) L::store(o+i,Op::template v<L>(L::load(a+i),vs));
+ for (; i<n; i++) o[i]=Op::s(a[i],s);
+}
+
+template<class T,class Op> static void loopSV(T s,const T*b,T*o,size_t n) {
+ typedef Lanes<T> L;
+ typename L::V vs=L::set1(s);
+ size_t i=0;
+ for (; i+L::N<=n; i+=L::N) L::store(o+i,Op::template v<L>(vs,L::load(b+i)));
+ for (; i<n; i++) o[i]=Op::s(s,b[i]);
+}
+
+template<class T,class Op> static void loopV(const T*a,T*o,size_t n) {
+ typedef Lanes<T> L;
+ size_t i=0;
+ for (; i+L::N<=n; i+=L::N) L::store(o+i,Op::template v<L>(L::load(a+i)));
+ for (; i<n; i++) o[i]=Op::template v<scalar::Lanes<T> >(a[i]);
+}
+
+// x^k by binary exponentiation
+template<class T> static void powInt(const T*a,int k,T*o,size_t n) {
+ typedef Lanes<T> L;
+ unsigned m0=k<0 ? -k : k;
+ typename L::V one=L::set1(T(1));
+ size_t i=0;
+ for (; i+L::N<=n; i+=L::N) {
+  typename L::V x=L::load(a+i),r=one;
+  for (unsigned m=m0; m; m>>=1) {
+   if (m&1) r=L::mul(r,x);
+   x=L::mul(x,x);
+  }
+  L::store(o+i,k<0 ? L::div(one,r) : r);
+ }
+ for (; i<n; i++) {
+  T x=a[i],r=1;
+  for (unsigned m=m0; m; m>>=1) {
+   if (m&1) r*=x;
+   x*=x;
+  }
+  o[i]=k<0 ? 1/r : r;
+ }
+}
+
+// x^e for float by binary exponentiation in double for integer e,
+// |e| <= 64, rounded once to float as plotmath.inl does (correctly, but
+// for rare halfway cases, subnormal results included); by plotmath.inl
+// or pow() for any other exponent.
+static void loopPow(const float*a,float e,float*o,size_t n) {
+ if (e>=-64 && e<=64 && float(int(e))==e) {
+  double t[256];
+  for (size_t i=0; i<n; i+=256) {
+   size_t m=n-i<256 ? n-i : 256;
+   for (size_t k=0; k<m; k++) t[k]=a[i+k];
+   powInt(t,int(e),t,m);
+   for (size_t k=0; k<m; k++) o[i+k]=float(t[k]);
+  }
+ }else if (!(e-e==0) || !mathPow(a,e,o,n))	// infinite or NaN exponent: pow()
+  for (size_t i=0; i<n; i++) o[i]=std::pow(a[i],e);
+}
+
+// x^e for double: by a single operation for e = -1, 0, 1 or 2, where it
+// is exact; pow() for any other exponent.
+template<class T> static void loopPow(const T*a,T e,T*o,size_t n) {
+ if (e>=-1 && e<=2 && double(int(e))==e) powInt(a,int(e),o,n);
+ else for (size_t i=0; i<n; i++) o[i]=std::pow(a[i],e);
+}
+
+/* -------------------------------------------------------- */
+// Dispatch on the operation
+
+template<class T> static bool vv(int op,const T*a,const T*b,T*o,size_t n) {
+ switch (op) {
+  case PK_ADD: loopVV<T,Add>(a,b,o,n); return true;
+  case PK_SUB: loopVV<T,Sub>(a,b,o,n); return true;
+  case PK_MUL: loopVV<T,Mul>(a,b,o,n); return true;
+  case PK_DIV: loopVV<T,Div>(a,b,o,n); return true;
+ }
+ return false;
+}
+
+template<class T> static bool vs(int op,const T*a,T s,T*o,size_t n) {
+ switch (op) {
+  case PK_ADD: loopVS<T,Add>(a,s,o,n); return true;
+  case PK_SUB: loopVS<T,Sub>(a,s,o,n); return true;
+  case PK_MUL: loopVS<T,Mul>(a,s,o,n); return true;
+  case PK_DIV: loopVS<T,Div>(a,s,o,n); return true;
+  case PK_POW: loopPow(a,s,o,n); return true;
+ }
+ return false;
+}
+
+template<class T> static bool sv(int op,T s,const T*b,T*o,size_t n) {
+ switch (op) {
+  case PK_ADD: loopSV<T,Add>(s,b,o,n); return true;
+  case PK_SUB: loopSV<T,Sub>(s,b,o,n); return true;
+  case PK_MUL: loopSV<T,Mul>(s,b,o,n); return true;
+  case PK_DIV: loopSV<T,Div>(s,b,o,n); return true;
+ }
+ return false;
+}
+
+template<class T> static bool v(int op,const T*a,T*o,size_t n) {
+ switch (op) {
+  case PK_NEG: loopV<T,Neg>(a,o,n); return true;
+  case PK_SQRT: loopV<T,Sqrt>(a,o,n); return true;
+  case PK_FABS: loopV<T,Abs>(a,o,n); return true;
+ }
+ if (math(op,a,o,n)) return true;
+	// No vector code for these, or not for this element type
+ size_t i;
+ switch (op) {
+  case PK_SIN:	for (i=0; i<n; i++) o[i]=std::sin(a[i]); return true;
+  case PK_COS:	for (i=0; i<n; i++) o[i]=std::cos(a[i]); return true;
+  case PK_TAN:	for (i=0; i<n; i++) o[i]=std::tan(a[i]); return true;
+  case PK_ASIN:	for (i=0; i<n; i++) o[i]=std::asin(a[i]); return true;
+  case PK_ACOS:	for (i=0; i<n; i++) o[i]=std::acos(a[i]); return true;
+  case PK_ATAN:	for (i=0; i<n; i++) o[i]=std::atan(a[i]); return true;
+  case PK_SINH:	for (i=0; i<n; i++) o[i]=std::sinh(a[i]); return true;
+  case PK_COSH:	for (i=0; i<n; i++) o[i]=std::cosh(a[i]); return true;
+  case PK_TANH:	for (i=0; i<n; i++) o[i]=std::tanh(a[i]); return true;
+  case PK_LOG:	for (i=0; i<n; i++) o[i]=std::log(a[i]); return true;
+  case PK_LOG10:for (i=0; i<n; i++) o[i]=std::log10(a[i]); return true;
+  case PK_EXP:	for (i=0; i<n; i++) o[i]=std::exp(a[i]); return true;
+ }
+ return false;
+}
+
+/* -------------------------------------------------------- */
+// Range of the pairs (x[i],y[i]) that are both finite, see plotKernelRange.
+// Lanes that fail the finite test are replaced by +inf in the min and
+// -inf in the max, so they cannot change the result.
+
+template<class T,bool xy> static size_t rangeLoop(const T*x,const T*y,size_t n,T r[4]) {
+ typedef Lanes<T> L;
+ typedef typename L::V V;
+ const T inf=numeric_limits<T>::infinity();
+ V big=L::set1(numeric_limits<T>::max()), pinf=L::set1(inf), minf=L::set1(-inf);
+ V xlo=pinf, xhi=minf, ylo=pinf, yhi=minf;
+ size_t count=0, i=0;
+ for (; i+L::N<=n; i+=L::N) {
+  V a=L::load(x+i), m=L::le(L::abs(a),big), b=a;
+  if (xy) {
+   b=L::load(y+i);
+   m=L::band(m,L::le(L::abs(b),big));
+  }
+  xlo=L::min(xlo,L::bor(L::band(m,a),L::bandnot(m,pinf)));
+  xhi=L::max(xhi,L::bor(L::band(m,a),L::bandnot(m,minf)));
+  if (xy) {
+   ylo=L::min(ylo,L::bor(L::band(m,b),L::bandnot(m,pinf)));
+   yhi=L::max(yhi,L::bor(L::band(m,b),L::bandnot(m,minf)));
+  }
+  count+=L::count(m);
+ }
+ T t[4][L::N];
+ L::store(t[0],xlo); L::store(t[1],xhi); L::store(t[2],ylo); L::store(t[3],yhi);
+ for (int k=0; k<L::N; k++) {
+  if (r[0]>t[0][k]) r[0]=t[0][k];
+  if (r[1]<t[1][k]) r[1]=t[1][k];
+  if (xy && r[2]>t[2][k]) r[2]=t[2][k];
+  if (xy && r[3]<t[3][k]) r[3]=t[3][k];
+ }
+ for (; i<n; i++) {
+  if (!isfinite(x[i]) || (xy && !isfinite(y[i]))) continue;
+  if (r[0]>x[i]) r[0]=x[i];
+  if (r[1]<x[i]) r[1]=x[i];
+  if (xy && r[2]>y[i]) r[2]=y[i];
+  if (xy && r[3]<y[i]) r[3]=y[i];
+  count++;
+ }
+ return count;
+}
+
+template<class T> static size_t range(const T*x,const T*y,size_t n,T r[4]) {
+ return y ? rangeLoop<T,true>(x,y,n,r) : rangeLoop<T,false>(x,y,n,r);
+}
@@ -0,0 +1,172 @@
+/* File: plotload.cpp
+ *
+ * Loading of Plotdata columns from text files (Plotdata::load()).
+ *
+ * The file is mapped into memory (PlotFile.h), or read in one block
+ * when it cannot be, then cut into parts at line boundaries that are
+ * parsed on several threads (PlotThreads.h). Each part collects its
+ * rows and its malformed lines; the columns are then filled part by
+ * part, again in parallel, so the result is in file order.
+ *
+ * Numbers are parsed with std::from_chars when the library has it
+ * (C++17), which does not depend on the locale; with strtod otherwise.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__has_include)
+#if __has_include(<charconv>) && __cplusplus>=201703L
+#include <charconv>
+#endif
+#endif
+
+#include "PlotData.h"
+#include "PlotFile.h"
+#include "PlotThreads.h"
+
+static const size_t minPartBytes=1<<20;
+
+static inline bool blank(char c) {return c==' ' || c=='\t';}
+static inline bool comma(char c) {return c==',' || c==';';}
+
+static inline const char*skipBlank(const char*p, const char*e) {
+ while (p<e && blank(*p)) p++;
+ return p;
+}
+
+// Parse a number at p; the end of it, or 0 if there is none
+static const char*number(const char*p, const char*e, float_t&v) {
+ if (p<e && *p=='+') p++;	// from_chars does not take it
+#if defined(__cpp_lib_to_chars)
+ std::from_chars_result r=std::from_chars(p,e,v);
+ if (r.ec==std::errc()) return r.ptr;
+ if (r.ec!=std::errc::result_out_of_range) return 0;
+	// too large or too small for float_t: give inf or 0 as strtod
+#endif
+ char s[64];
+ size_t n=0;
+ while (p+n<e && n<sizeof s-1 && !blank(p[n]) && !comma(p[n]) && p[n]!='\r') {s[n]=p[n]; n++;}
+ s[n]=0;
+ char*end;
+ v=float_t(strtod(s,&end));
+ return end==s ? 0 : p+(end-s);
+}
+
+// Parse n fields of a line into v; false if malformed
+static bool parseLine(const char*p, const char*e, float_t*v, unsigned n) {
+ p=skipBlank(p,e);
+ for (unsigned k=0; k<n; k++) {
+  if (k) {			// separator: blanks, at most one comma
+   const char*s=p;
+   p=skipBlank(p,e);
+   bool c=p<e && comma(*p);
+   if (c) p=skipBlank(p+1,e);
+   else if (p==s || p==e) return false;	// no separator, or too few fields
+   if (c && (p==e || comma(*p))) {v[k]=NOPLOT; continue;}	// empty field
+  }else if (p<e && comma(*p)) {v[k]=NOPLOT; continue;}
+  p=number(p,e,v[k]);
+  if (!p) return false;
+ }
+ return p==e || blank(*p) || comma(*p);	// further fields are ignored
+}
+
+namespace{
+struct Part{
+ const char*begin,*end;
+ std::vector<float_t> rows;	// n values per row
+ std::vector<size_t> bad;	// line numbers within the part, from 1
+ size_t lines;
+};
+}
+
+static void parsePart(Part&t, unsigned n, bool first) {
+ t.rows.clear();
+ t.bad.clear();
+ t.lines=0;
+ bool seen=!first;		// a line with something on it, before
+ std::vector<float_t> v(n);
+ for (const char*p=t.begin; p<t.end; ) {
+  const char*q=(const char*)memchr(p,'\n',t.end-p);
+  if (!q) q=t.end;
+  const char*e=q>p && q[-1]=='\r' ? q-1 : q;
+  t.lines++;
+  const char*s=skipBlank(p,e);
+  if (s<e && *s!='#') {
+   if (parseLine(s,e,v.data(),n)) t.rows.insert(t.rows.end(),v.begin(),v.end());
+   else if (seen) t.bad.push_back(t.lines);	// else a header
+   seen=true;
+  }
+  p=q+1;
+ }
+}
+
+bool Plotdata::load(const char*path, Plotdata*const cols[], unsigned n, vector<size_t>*bad) {
+ if (bad) bad->clear();
+ if (!n) return false;
+	// the text
+ PlotMap map(path);
+ std::vector<char> block;
+ const char*text;
+ size_t size;
+ if (map.ok()) {
+  text=(const char*)map.data();
+  size=map.size();
+ }else{
+  FILE*f=fopen(path,"rb");
+  if (!f) return false;
+  char buf[1<<16];
+  for (size_t m; (m=fread(buf,1,sizeof buf,f))>0; ) block.insert(block.end(),buf,buf+m);
+  bool err=ferror(f)!=0;
+  fclose(f);
+  if (err) return false;
+  text=block.data();
+  size=block.size();
+ }
+	// parts, cut after a newline
+ unsigned parts=plotParts(size,minPartBytes);
+ std::vector<Part> part(parts);
+ const char*p=text,*end=text+size;
+ for (unsigned k=0; k<parts; k++) {
+  const char*q=k+1<parts ? text+size/parts*(k+1) : end;
+  if (q<p) q=p;
+  if (q<end) {
+   const char*nl=(const char*)memchr(q,'\n',end-q);
+   q=nl ? nl+1 : end;
+  }
+  part[k].begin=p;
+  part[k].end=q;
+  p=q;
+ }
+ plotParallel(parts,parts,[&](unsigned k,size_t,size_t){parsePart(part[k],n,k==0);});
+	// row and line numbers where each part starts
+ std::vector<size_t> row0(parts+1,0);
+ size_t line=0;
+ for (unsigned k=0; k<parts; k++) {
+  row0[k+1]=row0[k]+part[k].rows.size()/n;
+  if (bad) for (size_t i=0; i<part[k].bad.size(); i++) bad->push_back(line+part[k].bad[i]);
+  line+=part[k].lines;
+ }
+ for (unsigned c=0; c<n; c++) {
+  Plotdata&d=*cols[c];
+  d.release();
+  d.data.resize(row0[parts]);
+  d.cached=false;
+ }
+ plotParallel(parts,parts,[&](unsigned k,size_t,size_t){
+  const float_t*r=part[k].rows.data();
+  for (size_t i=row0[k]; i<row0[k+1]; i++)
+   for (unsigned c=0; c<n; c++) cols[c]->data[i]=*r++;
+ });
+ return true;
+}
+
+bool Plotdata::load(const char*path, Plotdata&x, Plotdata&y, vector<size_t>*bad) {
+ Plotdata*cols[2]={&x,&y};
+ return load(path,cols,2,bad);
+}
+
+bool Plotdata::load(const char*path, vector<size_t>*bad) {
+ Plotdata*cols[1]={this};
+ return load(path,cols,1,bad);
+}
@@ -0,0 +1,99 @@
+/* File: plotlod.cpp
+ *
+ * Levels of detail of a trace (see PlotLod.h).
+ *
+ * Level 0 reads the points a block at a time, on several threads; each
+ * level above merges pairs of entries of the one below, on several
+ * threads too while it is large. An odd last entry is left out of the
+ * level above; drawing takes it from its own level.
+ */
+#include <cmath>
+
+#include "PlotLod.h"
+
+typedef PlotLod::Entry Entry;
+
+static void summarize(const float_t*x, const float_t*y, size_t m, Entry&e) {
+ size_t ilo=0, ihi=0;
+ e.broken=false;
+ e.xmin=e.ymin=INFINITY;
+ e.xmax=e.ymax=-INFINITY;
+ for (size_t i=0; i<m; i++) {
+  if (!isfinite(x[i]) || !isfinite(y[i])) {e.broken=true; continue;}
+  if (x[i]<e.xmin) e.xmin=x[i];
+  if (x[i]>e.xmax) e.xmax=x[i];
+  if (y[i]<e.ymin) {e.ymin=y[i]; ilo=i;}
+  if (y[i]>e.ymax) {e.ymax=y[i]; ihi=i;}
+ }
+ e.first=y[0];
+ e.last=y[m-1];
+ e.minFirst=ilo<=ihi;
+}
+
+static Entry merge(const Entry&a, const Entry&b) {
+ Entry e;
+ bool lo=b.ymin<a.ymin, hi=b.ymax>a.ymax;	// taken from b
+ e.broken=a.broken||b.broken;
+ e.xmin=min(a.xmin,b.xmin);
+ e.xmax=max(a.xmax,b.xmax);
+ e.ymin=lo ? b.ymin : a.ymin;
+ e.ymax=hi ? b.ymax : a.ymax;
+ e.first=a.first;
+ e.last=b.last;
+ e.minFirst=lo==hi ? (lo ? b.minFirst : a.minFirst) : hi;
+ return e;
+}
+
+void PlotLod::build(const Plotview&x, const Plotview&y) {
+ clear();
+ size_t m=min(x.size(),y.size())/base;
+ if (!m) return;
+ n=m*base;
+ level.push_back(vector<Entry>(m));
+ Entry*e=level[0].data();
+ unsigned parts=plotParts(m,64);
+ vector<char> sorted(parts,1);		// x, by part, from the point before it
+ plotParallel(parts,m,[&](unsigned k,size_t j0,size_t j1){
+  float_t bx[base], by[base];
+  float_t last=j0 ? x[j0*base-1] : -INFINITY;
+  for (size_t j=j0; j<j1; j++) {
+   const float_t*xs=x.block(j*base,base,bx);
+   summarize(xs,y.block(j*base,base,by),base,e[j]);
+   for (size_t i=0; i<base && sorted[k]; i++) {
+    if (!isfinite(xs[i]) || !(xs[i]>=last)) sorted[k]=0;
+    last=xs[i];
+   }
+  }
+ });
+ ordered=find(sorted.begin(),sorted.end(),0)==sorted.end();
+ while (level.back().size()>1) {
+  const Entry*a=level.back().data();
+  size_t h=level.back().size()/2;
+  vector<Entry> b(h);
+  plotParallel(plotParts(h,1<<14),h,[&](unsigned,size_t j0,size_t j1){
+   for (size_t j=j0; j<j1; j++) b[j]=merge(a[2*j],a[2*j+1]);
+  });
+  level.push_back(std::move(b));
+ }
+}
+
+void PlotLod::range(const Plotview&x, const Plotview&y, size_t points,
+ Plotdata::Range&xr, Plotdata::Range&yr) const{
+ xr.init();
+ yr.init();
+ for (size_t j=0, m=n/base; j<m; ) {
+  unsigned k=top(j,m);
+  const Entry&e=level[k][j>>k];
+  xr.expand(e.xmin,e.xmax);
+  yr.expand(e.ymin,e.ymax);
+  j+=size_t(1)<<k;
+ }
+ Entry e;
+ float_t bx[base], by[base];
+ for (size_t i0=n; i0<points; i0+=base) {
+  size_t m=points-i0<base ? points-i0 : base;
+  summarize(x.block(i0,m,bx),y.block(i0,m,by),m,e);
+  xr.expand(e.xmin,e.xmax);
+  yr.expand(e.ymin,e.ymax);
+ }
+}
@@ -0,0 +1,177 @@
+/* File: plotpool.cpp
+ *
+ * Pooled memory for Plotdata elements (see PlotPool.h).
+ *
+ * Each block starts with a header telling where it comes from: the heap,
+ * a size class of the pool, or a frame chunk. Pooled blocks have the size
+ * of their class; free ones are chained in one list per class, through
+ * their header, under a mutex.
+ * A chunk counts its blocks in use, plus one for its frame while the frame
+ * lasts: whoever drops the count to zero makes the chunk idle, to be taken
+ * again by the next frame.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "PlotPool.h"
+
+namespace{
+struct Head{void*link; size_t cls;};	// link: chunk, or next free block
+const size_t headSize=(sizeof(Head)+15)&~size_t(15);	// keeps malloc's alignment
+const size_t HEAP=~size_t(0), FRAME=HEAP-1;	// cls of blocks not pooled
+
+const size_t minBlock=256;		// bytes, header included
+const unsigned maxExp=18;		// classes up to minBlock<<18, 64 MB
+const size_t classes=4*maxExp+1;
+
+size_t classSize(size_t c) {return (minBlock<<(c/4))/4*(4+c%4);}
+
+// The smallest class of at least b bytes, "classes" if none
+size_t classOf(size_t b) {
+ if (b<=minBlock) return 0;
+ unsigned e=0;
+ while (e<maxExp && (minBlock<<(e+1))<b) e++;	// minBlock<<e < b
+ if (e==maxExp) return classes;
+ size_t q=(minBlock<<e)/4;
+ return 4*e+(b-(minBlock<<e)+q-1)/q;
+}
+
+std::mutex lock;
+Head*freeList[classes];			// zero before any constructor runs
+PlotFrame::Chunk*idle;
+std::atomic<bool> pooling(false);
+std::atomic<size_t> fresh(0), reused(0), held(0);
+thread_local PlotFrame*current=0;
+}
+
+struct PlotFrame::Chunk{
+ std::atomic<size_t> live;
+ size_t size,used;			// bytes after the chunk header
+ bool recycled;
+ Chunk*next;				// in its frame, or idle
+};
+static const size_t chunkHead=(sizeof(PlotFrame::Chunk)+15)&~size_t(15);
+
+bool plotPooling() {return pooling;}
+
+void plotSetPooling(bool on) {
+ pooling=on;
+ if (!on) plotPoolTrim();
+}
+
+PlotPoolStats plotPoolStats() {
+ PlotPoolStats s={fresh,reused,held};
+ return s;
+}
+
+void plotPoolTrim() {
+ std::lock_guard<std::mutex> g(lock);
+ for (size_t c=0; c<classes; c++) while (Head*h=freeList[c]) {
+  freeList[c]=(Head*)h->link;
+  held-=classSize(c);
+  free(h);
+ }
+ while (PlotFrame::Chunk*c=idle) {
+  idle=c->next;
+  held-=c->size;
+  c->~Chunk();
+  free(c);
+ }
+}
+
+void*plotAllocate(size_t bytes) {
+ if (bytes>~size_t(0)/2) throw std::bad_alloc();
+ if (current) if (void*p=current->allocate(bytes)) return p;
+ size_t b=(bytes+headSize+15)&~size_t(15);
+ size_t c=pooling ? classOf(b) : classes;
+ Head*h=0;
+ if (c<classes) {
+  b=classSize(c);
+  std::lock_guard<std::mutex> g(lock);
+  if ((h=freeList[c])) {
+   freeList[c]=(Head*)h->link;
+   held-=b;
+   reused+=b;
+  }
+ }
+ if (!h) {
+  h=(Head*)malloc(b);
+  if (!h) throw std::bad_alloc();
+  fresh+=b;
+ }
+ h->link=0;
+ h->cls=c<classes ? c : HEAP;
+ return (char*)h+headSize;
+}
+
+static void drop(PlotFrame::Chunk*c) {
+ if (--c->live) return;
+ std::lock_guard<std::mutex> g(lock);
+ c->next=idle;
+ idle=c;
+ held+=c->size;
+}
+
+void plotDeallocate(void*p) {
+ if (!p) return;
+ Head*h=(Head*)((char*)p-headSize);
+ if (h->cls==FRAME) drop((PlotFrame::Chunk*)h->link);
+ else if (h->cls!=HEAP && pooling) {
+  std::lock_guard<std::mutex> g(lock);
+  h->link=freeList[h->cls];
+  freeList[h->cls]=h;
+  held+=classSize(h->cls);
+ }else free(h);
+}
+
+PlotFrame::PlotFrame(size_t chunk)
+:outer(current),chunkSize(chunk<4096 ? 4096 : chunk),chunks(0) {
+ current=this;
+}
+
+PlotFrame::~PlotFrame() {
+ current=outer;
+ while (Chunk*c=chunks) {
+  chunks=c->next;
+  drop(c);				// the frame's count
+ }
+}
+
+void*PlotFrame::allocate(size_t bytes) {
+ if (bytes>chunkSize/4) return 0;
+ size_t b=(bytes+headSize+15)&~size_t(15);
+ Chunk*c=chunks;
+ if (!c || c->size-c->used<b) {
+  c=0;
+  {
+   std::lock_guard<std::mutex> g(lock);
+   for (Chunk**p=&idle; *p; p=&(*p)->next) if ((*p)->size==chunkSize) {
+    c=*p;
+    *p=c->next;
+    held-=c->size;
+    c->recycled=true;
+    break;
+   }
+  }
+  if (!c) {
+   void*m=malloc(chunkHead+chunkSize);
+   if (!m) throw std::bad_alloc();
+   c=new(m) Chunk;
+   c->size=chunkSize;
+   c->recycled=false;
+  }
+  c->live=1;
+  c->used=0;
+  c->next=chunks;
+  chunks=c;
+ }
+ Head*h=(Head*)((char*)c+chunkHead+c->used);
+ c->used+=b;
+ c->live++;
+ (c->recycled ? reused : fresh)+=b;
+ h->link=c;
+ h->cls=FRAME;
+ return (char*)h+headSize;
+}
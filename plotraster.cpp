@@ -0,0 +1,192 @@
+/* File: plotraster.cpp
+ *
+ * Implementation class PlotRaster
+ * A PlotCanvas drawing into an RGBA image in memory (see PlotRaster.h).
+ *
+ * Lines are rasterized by a closed formula rather than by stepping
+ * from one end: the pixel at step k of a line is computed from k alone.
+ * So a line is clipped to the image, or to the rectangle of clip(), without
+ * changing any of its pixels, however far outside its ends are.
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "PlotRaster.h"
+
+// 5x7 dot font, characters 32 to 126, one byte per column, bit 0 at top
+static const unsigned char font[95][5]={
+ {0x00,0x00,0x00,0x00,0x00},{0x00,0x00,0x5F,0x00,0x00},{0x00,0x07,0x00,0x07,0x00},{0x14,0x7F,0x14,0x7F,0x14},
+ {0x24,0x2A,0x7F,0x2A,0x12},{0x23,0x13,0x08,0x64,0x62},{0x36,0x49,0x55,0x22,0x50},{0x00,0x05,0x03,0x00,0x00},
+ {0x00,0x1C,0x22,0x41,0x00},{0x00,0x41,0x22,0x1C,0x00},{0x14,0x08,0x3E,0x08,0x14},{0x08,0x08,0x3E,0x08,0x08},
+ {0x00,0x50,0x30,0x00,0x00},{0x08,0x08,0x08,0x08,0x08},{0x00,0x60,0x60,0x00,0x00},{0x20,0x10,0x08,0x04,0x02},
+ {0x3E,0x51,0x49,0x45,0x3E},{0x00,0x42,0x7F,0x40,0x00},{0x42,0x61,0x51,0x49,0x46},{0x21,0x41,0x45,0x4B,0x31},	// 0-3
+ {0x18,0x14,0x12,0x7F,0x10},{0x27,0x45,0x45,0x45,0x39},{0x3C,0x4A,0x49,0x49,0x30},{0x01,0x71,0x09,0x05,0x03},	// 4-7
+ {0x36,0x49,0x49,0x49,0x36},{0x06,0x49,0x49,0x29,0x1E},{0x00,0x36,0x36,0x00,0x00},{0x00,0x56,0x36,0x00,0x00},	// 8-;
+ {0x08,0x14,0x22,0x41,0x00},{0x14,0x14,0x14,0x14,0x14},{0x00,0x41,0x22,0x14,0x08},{0x02,0x01,0x51,0x09,0x06},	// <-?
+ {0x32,0x49,0x79,0x41,0x3E},{0x7E,0x11,0x11,0x11,0x7E},{0x7F,0x49,0x49,0x49,0x36},{0x3E,0x41,0x41,0x41,0x22},	// @-C
+ {0x7F,0x41,0x41,0x22,0x1C},{0x7F,0x49,0x49,0x49,0x41},{0x7F,0x09,0x09,0x01,0x01},{0x3E,0x41,0x41,0x51,0x32},	// D-G
+ {0x7F,0x08,0x08,0x08,0x7F},{0x00,0x41,0x7F,0x41,0x00},{0x20,0x40,0x41,0x3F,0x01},{0x7F,0x08,0x14,0x22,0x41},	// H-K
+ {0x7F,0x40,0x40,0x40,0x40},{0x7F,0x02,0x04,0x02,0x7F},{0x7F,0x04,0x08,0x10,0x7F},{0x3E,0x41,0x41,0x41,0x3E},	// L-O
+ {0x7F,0x09,0x09,0x09,0x06},{0x3E,0x41,0x51,0x21,0x5E},{0x7F,0x09,0x19,0x29,0x46},{0x46,0x49,0x49,0x49,0x31},	// P-S
+ {0x01,0x01,0x7F,0x01,0x01},{0x3F,0x40,0x40,0x40,0x3F},{0x1F,0x20,0x40,0x20,0x1F},{0x7F,0x20,0x18,0x20,0x7F},	// T-W
+ {0x63,0x14,0x08,0x14,0x63},{0x03,0x04,0x78,0x04,0x03},{0x61,0x51,0x49,0x45,0x43},{0x00,0x7F,0x41,0x41,0x00},	// X-[
+ {0x02,0x04,0x08,0x10,0x20},{0x00,0x41,0x41,0x7F,0x00},{0x04,0x02,0x01,0x02,0x04},{0x40,0x40,0x40,0x40,0x40},	// \-_
+ {0x00,0x01,0x02,0x04,0x00},{0x20,0x54,0x54,0x54,0x78},{0x7F,0x48,0x44,0x44,0x38},{0x38,0x44,0x44,0x44,0x20},	// `-c
+ {0x38,0x44,0x44,0x48,0x7F},{0x38,0x54,0x54,0x54,0x18},{0x08,0x7E,0x09,0x01,0x02},{0x08,0x14,0x54,0x54,0x3C},	// d-g
+ {0x7F,0x08,0x04,0x04,0x78},{0x00,0x44,0x7D,0x40,0x00},{0x20,0x40,0x44,0x3D,0x00},{0x00,0x7F,0x10,0x28,0x44},	// h-k
+ {0x00,0x41,0x7F,0x40,0x00},{0x7C,0x04,0x18,0x04,0x78},{0x7C,0x08,0x04,0x04,0x78},{0x38,0x44,0x44,0x44,0x38},	// l-o
+ {0x7C,0x14,0x14,0x14,0x08},{0x08,0x14,0x14,0x18,0x7C},{0x7C,0x08,0x04,0x04,0x08},{0x48,0x54,0x54,0x54,0x20},	// p-s
+ {0x04,0x3F,0x44,0x40,0x20},{0x3C,0x40,0x40,0x20,0x7C},{0x1C,0x20,0x40,0x20,0x1C},{0x3C,0x40,0x30,0x40,0x3C},	// t-w
+ {0x44,0x28,0x10,0x28,0x44},{0x0C,0x50,0x50,0x50,0x3C},{0x44,0x64,0x54,0x4C,0x44},{0x00,0x08,0x36,0x41,0x00},	// x-{
+ {0x00,0x00,0x7F,0x00,0x00},{0x00,0x41,0x36,0x08,0x00},{0x02,0x01,0x02,0x04,0x02}};				// |-~
+
+static const int fontScale=2;			// font dots per pixel, in x and y
+static const int cellX=6*fontScale, cellY=8*fontScale;	// character cell
+
+static inline uint32_t opaque(Color c) {return (uint32_t(c)&0xFFFFFF)|0xFF000000;}
+
+PlotRaster::PlotRaster(int width, int height, Color background)
+:w(0),h(0),bg(background),ink(opaque(BLACK)),penWidth(1),penStyle(SOLID),
+ curX(0),curY(0),dots(0) {
+ resize(width,height);
+}
+
+void PlotRaster::resize(int width, int height) {
+ w=width>0 ? width : 0;
+ h=height>0 ? height : 0;
+ px.assign(size_t(w)*h,opaque(bg));
+ unclip();
+}
+
+void PlotRaster::clip(int l, int t, int r, int b) {
+ cl=l>0 ? l : 0;
+ ct=t>0 ? t : 0;
+ cr=r<w ? r : w;
+ cb=b<h ? b : h;
+}
+
+void PlotRaster::clear() {
+ std::fill(px.begin(),px.end(),opaque(bg));
+}
+
+void PlotRaster::erase(Color colour) {
+ std::fill(px.begin(),px.end(),opaque(colour));
+}
+
+bool PlotRaster::copy(const PlotCanvas&layer) {
+ const PlotRaster*r=dynamic_cast<const PlotRaster*>(&layer);
+ if (!r || r->w!=w || r->h!=h) return false;
+ px=r->px;			// same size: no allocation
+ return true;
+}
+
+void PlotRaster::fill(int l, int t, int r, int b, uint32_t c) {
+ if (l<0) l=0;
+ if (t<0) t=0;
+ if (r>w) r=w;
+ if (b>h) b=h;
+ if (l>=r) return;
+ for (int y=t; y<b; y++) std::fill(px.begin()+(size_t(y)*w+l),px.begin()+(size_t(y)*w+r),c);
+}
+
+void PlotRaster::plot(int x, int y) {
+ if (penWidth<=1) {
+  if (x>=cl && x<cr && y>=ct && y<cb) px[size_t(y)*w+x]=ink;
+ }else{
+  int l=x-penWidth/2, t=y-penWidth/2;
+  fill(max(l,cl),max(t,ct),min(l+penWidth,cr),min(t+penWidth,cb),ink);
+ }
+}
+
+void PlotRaster::pen(Color colour, int width, PenStyle style) {
+ ink=opaque(colour);
+ penWidth=width;
+ penStyle=style;
+}
+
+void PlotRaster::moveto(int x, int y) {
+ curX=x;
+ curY=y;
+ dots=0;
+}
+
+/* Step k (0 <= k < n) of the line goes k pixels along its major axis and
+ * off(k) = (2*k*minor + major) / (2*major) pixels along the other, that is
+ * the nearest pixel to the ideal line, rounding halves away from the start.
+ * off(k) never decreases, so the steps inside the image form one range,
+ * found by bisection.
+ */
+void PlotRaster::lineto(int x, int y) {
+ long long dx=(long long)x-curX, dy=(long long)y-curY;
+ int sx=dx<0 ? -1 : 1, sy=dy<0 ? -1 : 1;
+ long long adx=dx*sx, ady=dy*sy;
+ bool xmajor=adx>=ady;
+ long long major=xmajor ? adx : ady, minor=xmajor ? ady : adx;
+ int s0=xmajor ? sx : sy, s1=xmajor ? sy : sx;	// directions along major, minor
+ long long p0=xmajor ? curX : curY, p1=xmajor ? curY : curX;	// start
+ long long a0=xmajor ? cl : ct, b0=xmajor ? cr-1 : cb-1;	// clip range, along major
+ long long a1=xmajor ? ct : cl, b1=xmajor ? cb-1 : cr-1;	// and minor
+ long long m=penWidth/2+1;			// pen overhang
+ unsigned dot=dots;
+ dots+=unsigned(major);
+ curX=x;
+ curY=y;
+ if (!major) return;
+	// steps with the major coordinate inside the clip rectangle
+ long long k0=0, k1=major-1;
+ long long lo=s0>0 ? a0-m-p0 : p0-(b0+m), hi=s0>0 ? b0+m-p0 : p0-a0+m;
+ if (k0<lo) k0=lo;
+ if (k1>hi) k1=hi;
+ if (k0>k1) return;
+	// then with the minor coordinate inside too
+ long long two=2*major;
+ lo=s1>0 ? a1-m-p1 : p1-(b1+m);
+ hi=s1>0 ? b1+m-p1 : p1-a1+m;
+ long long a=k0, b=k1+1;		// first k with off(k) >= lo
+ while (a<b) {long long c=a+(b-a)/2; if ((2*c*minor+major)/two<lo) a=c+1; else b=c;}
+ k0=a;
+ a=k0; b=k1+1;				// first k with off(k) > hi
+ while (a<b) {long long c=a+(b-a)/2; if ((2*c*minor+major)/two<=hi) a=c+1; else b=c;}
+ k1=a-1;
+ long long num=2*k0*minor+major, off=num/two, rem=num%two;
+ for (long long k=k0; k<=k1; k++) {
+  if (penStyle==SOLID || !((dot+k)&1)) {
+   int u=int(p0+s0*k), v=int(p1+s1*off);
+   if (xmajor) plot(u,v); else plot(v,u);
+  }
+  rem+=2*minor;
+  if (rem>=two) {rem-=two; off++;}
+ }
+}
+
+void PlotRaster::rectangle(int l, int t, int r, int b, Color colour) {
+ int x=curX, y=curY;
+ unsigned d=dots;
+ fill(l+1,t+1,r-1,b-1,opaque(colour));
+ moveto(l,t);
+ lineto(r-1,t);
+ lineto(r-1,b-1);
+ lineto(l,b-1);
+ lineto(l,t);
+ curX=x; curY=y; dots=d;
+}
+
+void PlotRaster::textSize(const char*s, int&cx, int&cy) {
+ size_t n=strlen(s);
+ cx=n ? int(n)*cellX-fontScale : 0;
+ cy=cellY;
+}
+
+void PlotRaster::text(int x, int y, const char*s, TextAlign align, Color colour) {
+ int cx,cy;
+ textSize(s,cx,cy);
+ if (align==CENTER) x-=cx/2;
+ else if (align==RIGHT) x-=cx;
+ uint32_t c=opaque(colour);
+ for (; *s; s++, x+=cellX) {
+  unsigned ch=(unsigned char)*s;
+  const unsigned char*g=font[ch>=32 && ch<127 ? ch-32 : '?'-32];
+  for (int i=0; i<5; i++) for (int j=0; j<7; j++) if (g[i]>>j&1)
+   fill(x+i*fontScale,y+j*fontScale,x+(i+1)*fontScale,y+(j+1)*fontScale,c);
+ }
+}
@@ -0,0 +1,92 @@
+/* File: plotsample.cpp
+ *
+ * Adaptive sampling of functions (Plotdata::sample()).
+ *
+ * f is first evaluated on a grid of one point per gridPixels pixels of
+ * the plot. Each interval of the grid is then halved as long as the
+ * value of f at its middle is more than the tolerance away from the
+ * line joining its ends, up to maxDepth times. A smooth curve is
+ * straight at a small enough scale, so it stops being halved soon.
+ * An interval still off the line after maxDepth halvings, with ends
+ * far apart and one half holding most of the difference, holds a jump
+ * or a pole: a NOPLOT there breaks the line. Middle points, once
+ * evaluated, are kept.
+ * Where f is defined at one end only, the interval is halved to find
+ * the edge. The vertical scale is that of the values on the grid.
+ */
+#include <cmath>
+
+#include "PlotData.h"
+
+static const int gridPixels=8;
+static const int maxDepth=9;		// intervals down to 1/64 pixel
+static const float_t jumpPixels=2;	// a jump at maxDepth, not a steep line,
+static const float_t jumpShare=0.9;	// if one half has most of it
+
+namespace{
+template<class F> struct Sampler{
+ F f;
+ float_t tol,jump;		// in y units
+ Plotdata&x,&y;
+ Sampler(F fn, Plotdata&px, Plotdata&py):f(fn),x(px),y(py) {}
+ void point(float_t a, float_t b) {x.point(a); y.point(b);}
+	// points after x0 up to x1, x0 being done
+ void refine(float_t x0, float_t y0, float_t x1, float_t y1, int depth) {
+  bool f0=isfinite(y0), f1=isfinite(y1);
+  if (f0 || f1) {
+   float_t xm=(x0+x1)/2, ym=f(xm);
+   if (depth<maxDepth) {
+    if (!f0 || !f1 || !isfinite(ym) || fabs(ym-(y0+y1)/2)>tol) {
+     refine(x0,y0,xm,ym,depth+1);
+     refine(xm,ym,x1,y1,depth+1);
+     return;
+    }
+   }else if (f0 && f1 && isfinite(ym)) {
+	// a jump stays whole in one half, a steep line shares out
+    float_t d=fabs(y1-y0);
+    if (d>jump && (fabs(ym-y0)>jumpShare*d || fabs(y1-ym)>jumpShare*d)) ym=NOPLOT;
+   }
+   point(xm,ym);			// evaluated anyway
+  }
+  point(x1,y1);
+ }
+ void run(float_t lo, float_t hi, int width, int height, float_t tolerance) {
+  x.clear();
+  y.clear();
+  if (!(lo<hi) || width<1 || height<1) return;	// and NaN
+  size_t n=size_t(width/gridPixels);
+  if (n<16) n=16;
+  vector<float_t> g(n+1);
+  Plotdata::Range r;
+  r.init();
+  for (size_t i=0; i<=n; i++) {
+   g[i]=f(lo+(hi-lo)*i/n);
+   if (isfinite(g[i])) r.expand(g[i]);
+  }
+  float_t span=r.max-r.min;
+  if (!(span>0)) span=r.min<=r.max && r.max!=0 ? fabs(r.max) : 1;
+  tol=span/height*tolerance;
+  jump=span/height*jumpPixels;
+  point(lo,g[0]);
+  for (size_t i=0; i<n; i++)
+   refine(lo+(hi-lo)*i/n,g[i],lo+(hi-lo)*(i+1)/n,g[i+1],0);
+ }
+};
+
+struct Bound{
+ BinFunc f;
+ float_t op2;
+ float_t operator()(float_t v) const {return f(v,op2);}
+};
+}
+
+void Plotdata::sample(Func f, float_t lo, float_t hi, Plotdata&x, Plotdata&y,
+                      int width, int height, float_t tolerance) {
+ Sampler<Func>(f,x,y).run(lo,hi,width,height,tolerance);
+}
+
+void Plotdata::sample(BinFunc f, float_t op2, float_t lo, float_t hi, Plotdata&x, Plotdata&y,
+                      int width, int height, float_t tolerance) {
+ Bound b={f,op2};
+ Sampler<Bound>(b,x,y).run(lo,hi,width,height,tolerance);
+}
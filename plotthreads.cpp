@@ -0,0 +1,190 @@
+/* File: plotthreads.cpp
+ *
+ * Splitting of large loops across processor cores (see PlotThreads.h).
+ */
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PlotThreads.h"
+
+static unsigned threads() {
+ unsigned n=std::thread::hardware_concurrency();
+ return n ? n : 1;
+}
+
+static std::atomic<unsigned>&threadCount() {
+ static std::atomic<unsigned> n(threads());
+ return n;
+}
+
+unsigned plotThreads() {return threadCount();}
+
+void plotSetThreads(unsigned n) {threadCount()=n ? n : 1;}
+
+unsigned plotParts(size_t n, size_t minPart) {
+ size_t parts=minPart ? n/minPart : n;
+ unsigned t=threadCount();
+ if (parts>t) parts=t;
+ return parts ? unsigned(parts) : 1;
+}
+
+void plotParallel(unsigned parts, size_t n,
+                  const std::function<void(unsigned,size_t,size_t)>&f) {
+ if (parts<=1) {f(0,0,n); return;}
+	// part k begins at k*n/parts, computed without overflow
+ size_t q=n/parts, r=n%parts;
+ std::mutex m;
+ std::exception_ptr error;	// first thrown by f
+ auto part=[&](unsigned k,size_t i0,size_t i1){
+  try {
+   f(k,i0,i1);
+  }catch (...) {
+   std::lock_guard<std::mutex> l(m);
+   if (!error) error=std::current_exception();
+  }
+ };
+ std::vector<std::thread> t;
+ t.reserve(parts-1);
+ try {
+  for (unsigned k=1; k<parts; k++)
+   t.push_back(std::thread(part,k,q*k+r*k/parts,q*(k+1)+r*(k+1)/parts));
+ }catch (...) {			// no thread: the parts left run here
+  for (unsigned k=unsigned(t.size())+1; k<parts; k++) part(k,q*k+r*k/parts,q*(k+1)+r*(k+1)/parts);
+ }
+ part(0,0,q);
+ for (unsigned k=0; k<t.size(); k++) t[k].join();
+ if (error) std::rethrow_exception(error);
+}
+
+/* -------------------------------------------------------- */
+// Pool of threads for plotParallelChunks()
+
+namespace{
+class Pool{
+public:
+ Pool():job(0),generation(0),workers(0),finished(0),quit(false) {}
+ ~Pool();
+	// false if in use, or called from one of its threads
+ bool run(size_t n, size_t chunk, const std::function<void(size_t,size_t)>&f);
+private:
+ struct Share{			// chunks [next,end) of one thread
+  std::atomic<size_t> next;
+  size_t end;
+  char pad[64-sizeof(size_t)-sizeof(std::atomic<size_t>)];	// own cache line
+ };
+ std::mutex use;		// held by the thread running a job
+ std::mutex m;			// guards what follows
+ std::condition_variable wake,done;
+ std::vector<std::thread> threads;
+ std::vector<Share> shares;
+ const std::function<void(size_t,size_t)>*job;
+ size_t n,chunk;
+ unsigned generation;		// of the job
+ unsigned workers;		// threads on the job, the calling one included
+ unsigned finished;		// pool threads done with it
+ std::exception_ptr error;	// first thrown by the job
+ bool quit;
+ void loop(unsigned k);
+ void work(unsigned k);
+};
+}
+
+static thread_local bool inPool=false;	// running chunks of a job
+
+Pool::~Pool() {
+ {
+  std::lock_guard<std::mutex> l(m);
+  quit=true;
+ }
+ wake.notify_all();
+ for (size_t k=0; k<threads.size(); k++) threads[k].join();
+}
+
+// Thread k+1 of the pool
+void Pool::loop(unsigned k) {
+ inPool=true;
+ unsigned seen=0;
+ std::unique_lock<std::mutex> l(m);
+ for (;;) {
+  wake.wait(l,[&]{return quit || generation!=seen;});
+  if (quit) return;
+  seen=generation;
+  if (k+1>=workers) continue;	// not needed this time
+  l.unlock();
+  work(k+1);
+  l.lock();
+  if (++finished==workers-1) done.notify_one();
+ }
+}
+
+// Chunks of share k, then of the others; on an exception, keep the first
+// one for run() and leave the chunks not begun
+void Pool::work(unsigned k) {
+ try {
+  for (unsigned j=0; j<workers; j++) {
+   Share&s=shares[(k+j)%workers];
+   for (size_t c; (c=s.next.fetch_add(1))<s.end; ) {
+    size_t i0=c*chunk;
+    (*job)(i0,n-i0<chunk ? n : i0+chunk);
+   }
+  }
+ }catch (...) {
+  std::lock_guard<std::mutex> l(m);
+  if (!error) error=std::current_exception();
+  for (unsigned j=0; j<workers; j++) shares[j].next=shares[j].end;
+ }
+}
+
+bool Pool::run(size_t count, size_t size, const std::function<void(size_t,size_t)>&f) {
+ if (inPool || !use.try_lock()) return false;
+ std::lock_guard<std::mutex> u(use,std::adopt_lock);
+ size_t chunks=(count+size-1)/size;
+ unsigned w=plotThreads();
+ if (w>chunks) w=unsigned(chunks);
+ if (w<=1) return false;
+ {
+  std::lock_guard<std::mutex> l(m);
+  while (threads.size()<w-1) threads.push_back(std::thread(&Pool::loop,this,unsigned(threads.size())));
+  if (shares.size()<w) std::vector<Share>(w).swap(shares);
+  for (unsigned k=0; k<w; k++) {
+   shares[k].next=chunks*k/w;
+   shares[k].end=chunks*(k+1)/w;
+  }
+  job=&f;
+  n=count;
+  chunk=size;
+  workers=w;
+  finished=0;
+  generation++;
+ }
+ wake.notify_all();
+ inPool=true;			// f runs here too
+ work(0);
+ inPool=false;
+ std::exception_ptr e;
+ {
+  std::unique_lock<std::mutex> l(m);
+  done.wait(l,[&]{return finished==workers-1;});
+  e.swap(error);
+ }
+ if (e) std::rethrow_exception(e);
+ return true;
+}
+
+void plotParallelChunks(size_t n, size_t chunk,
+                        const std::function<void(size_t,size_t)>&f) {
+ if (!chunk) chunk=1;
+ static Pool pool;
+ if (n>chunk && pool.run(n,chunk,f)) return;
+ for (size_t i0=0; i0<n; i0+=chunk) f(i0,n-i0<chunk ? n : i0+chunk);
+}
+
+static std::atomic<bool> parallelCalls(false);
+
+bool plotParallelCalls() {return parallelCalls;}
+
+void plotSetParallelCalls(bool on) {parallelCalls=on;}
@@ -0,0 +1,379 @@
+/* File: plotvector.cpp
+ *
+ * Implementation classes PlotVector, PlotSvg, PlotPdf
+ * PlotCanvases writing SVG and PDF files (see PlotVector.h).
+ *
+ * Drawing coordinates are shifted by half a pixel, so that one pixel
+ * wide lines on whole pixel coordinates cover whole pixels, as on screen.
+ */
+#include <cstring>
+
+#include "PlotVector.h"
+
+static const size_t bufSize=1<<16;	// output buffer
+static const size_t window=4096;	// points simplified at a time
+
+/* -------------------------------------------------------- */
+// PlotVector
+
+PlotVector::PlotVector(const char*path, int width, int height)
+:w(width),h(height),ink(BLACK),penWidth(1),penStyle(SOLID),
+ f(fopen(path,"wb")),failed(false),count(0),tol2(0.25),started(false),inPath(false) {
+ cur.x=cur.y=0;
+ buf.reserve(bufSize);
+ pts.reserve(window);
+}
+
+PlotVector::~PlotVector() {
+ if (f) fclose(f);
+}
+
+bool PlotVector::close() {
+ if (!f) return false;
+ flushPath();
+ finish();
+ if (!buf.empty() && fwrite(buf.data(),1,buf.size(),f)!=buf.size()) failed=true;
+ if (fclose(f)) failed=true;
+ f=0;
+ return !failed;
+}
+
+void PlotVector::put(const char*s, size_t n) {
+ if (!f) return;
+ if (buf.size()+n>bufSize) {
+  if (fwrite(buf.data(),1,buf.size(),f)!=buf.size()) failed=true;
+  count+=buf.size();
+  buf.clear();
+ }
+ buf.insert(buf.end(),s,s+n);
+}
+
+void PlotVector::put(const char*s) {put(s,strlen(s));}
+
+void PlotVector::put(long v) {
+ char s[24], *p=s+sizeof s;
+ unsigned long u=v<0 ? 0UL-v : v;
+ do *--p=char('0'+u%10); while (u/=10);
+ if (v<0) *--p='-';
+ put(p,s+sizeof s-p);
+}
+
+void PlotVector::put(double v) {
+ long m=long(v*1000+(v<0 ? -0.5 : 0.5));	// thousandths
+ if (m<0) {put("-",1); m=-m;}
+ put(m/1000);
+ if (m%1000) {
+  char s[5]={'.',char('0'+m/100%10),char('0'+m/10%10),char('0'+m%10),0};
+  int n=4;
+  while (s[n-1]=='0') n--;
+  put(s,n);
+ }
+}
+
+// Width of s in Arial/Helvetica, which the files ask for
+int PlotVector::textWidth(const char*s) {
+ int em=0;		// thousandths of the font size
+ for (; *s; s++) {
+  char c=*s;
+  em+=c>='0' && c<='9' ? 556 : c=='.' || c==',' || c==' ' ? 278 : c=='-' ? 333
+    : c>='A' && c<='Z' ? 667 : 556;
+ }
+ return (em*fontSize+500)/1000;
+}
+
+void PlotVector::textSize(const char*s, int&cx, int&cy) {
+ cx=textWidth(s);
+ cy=fontSize;
+}
+
+void PlotVector::pen(Color colour, int width, PenStyle style) {
+ flushPath();
+ ink=colour;
+ penWidth=width>0 ? width : 1;
+ penStyle=style;
+}
+
+void PlotVector::moveto(int x, int y) {
+ endLine();
+ cur.x=x;
+ cur.y=y;
+}
+
+void PlotVector::lineto(int x, int y) {
+ if (pts.empty()) pts.push_back(cur);
+ cur.x=x;
+ cur.y=y;
+ if (x==pts.back().x && y==pts.back().y) return;
+ pts.push_back(cur);
+ if (pts.size()<window) return;
+	// write this window, its last point starts the next
+ Point last=pts.back();
+ endLine();
+ pts.push_back(last);
+ started=true;
+}
+
+void PlotVector::flushPath() {
+ endLine();
+ if (inPath) endPath();
+ inPath=false;
+}
+
+void PlotVector::endLine() {
+ if (pts.size()>=2) {
+  simplify();
+  if (!inPath) beginPath();
+  inPath=true;
+  for (size_t i=started ? 1 : 0; i<pts.size(); i++)
+   if (keep[i]) pathPoint(pts[i],i==0);
+ }
+ pts.clear();
+ started=false;
+}
+
+/* Douglas-Peucker: keep the point farthest from the segment between two
+ * kept points if it is more than the tolerance away, and look again on
+ * each side of it. Distance is to the segment, not to the line through
+ * it, so that spikes going back along a line are kept.
+ */
+void PlotVector::simplify() {
+ size_t n=pts.size();
+ keep.assign(n,0);
+ keep[0]=keep[n-1]=1;
+ spans.clear();
+ spans.push_back(std::make_pair(size_t(0),n-1));
+ while (!spans.empty()) {
+  size_t a=spans.back().first, b=spans.back().second;
+  spans.pop_back();
+  if (b-a<2) continue;
+  double ax=pts[a].x, ay=pts[a].y;
+  double dx=pts[b].x-ax, dy=pts[b].y-ay, len2=dx*dx+dy*dy;
+  double far=-1;
+  size_t m=a;
+  for (size_t i=a+1; i<b; i++) {
+   double px=pts[i].x-ax, py=pts[i].y-ay;
+   double t=len2>0 ? (px*dx+py*dy)/len2 : 0;
+   if (t<0) t=0; else if (t>1) t=1;
+   px-=t*dx;
+   py-=t*dy;
+   double d2=px*px+py*py;
+   if (d2>far) {far=d2; m=i;}
+  }
+  if (far>tol2) {
+   keep[m]=1;
+   spans.push_back(std::make_pair(a,m));
+   spans.push_back(std::make_pair(m,b));
+  }
+ }
+}
+
+/* -------------------------------------------------------- */
+// PlotSvg
+
+PlotSvg::PlotSvg(const char*path, int width, int height)
+:PlotVector(path,width,height),clips(0),clipped(false) {
+ put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+   "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+ put(long(w)); put("\" height=\""); put(long(h));
+ put("\" viewBox=\"0 0 "); put(long(w)); put(" "); put(long(h)); put("\">\n");
+ put("<rect width=\"100%\" height=\"100%\" fill=\"#fff\"/>\n"
+   "<g transform=\"translate(.5 .5)\" font-family=\"Arial,Helvetica,sans-serif\" font-size=\"");
+ put(long(fontSize));
+ put("\" stroke-linejoin=\"round\">\n");
+}
+
+void PlotSvg::colour(Color c) {
+ static const char hex[]="0123456789abcdef";
+ int v[3]={GetRValue(c),GetGValue(c),GetBValue(c)};
+ char s[8]={'#'};
+ for (int i=0; i<3; i++) {s[1+2*i]=hex[v[i]>>4]; s[2+2*i]=hex[v[i]&15];}
+ put(s,7);
+}
+
+void PlotSvg::stroke() {
+ put(" stroke=\"");
+ colour(ink);
+ put("\"");
+ if (penWidth!=1) {put(" stroke-width=\""); put(long(penWidth)); put("\"");}
+ if (penStyle==DOT) put(" stroke-dasharray=\"1 1\"");
+}
+
+void PlotSvg::beginPath() {
+ put("<path fill=\"none\"");
+ stroke();
+ put(" d=\"");
+}
+
+void PlotSvg::pathPoint(Point p, bool start) {
+ put(start ? "M" : " ");
+ put(long(p.x));
+ put(" ");
+ put(long(p.y));
+}
+
+void PlotSvg::endPath() {put("\"/>\n");}
+
+void PlotSvg::erase(Color c) {
+ flushPath();
+ put("<rect x=\"-1\" y=\"-1\" width=\""); put(long(w+2));
+ put("\" height=\""); put(long(h+2)); put("\" fill=\"");
+ colour(c);
+ put("\"/>\n");
+}
+
+void PlotSvg::rectangle(int l, int t, int r, int b, Color fill) {
+ flushPath();
+ put("<rect x=\""); put(long(l)); put("\" y=\""); put(long(t));
+ put("\" width=\""); put(long(r-1-l)); put("\" height=\""); put(long(b-1-t));
+ put("\" fill=\"");
+ colour(fill);
+ put("\"");
+ stroke();
+ put("/>\n");
+}
+
+void PlotSvg::text(int x, int y, const char*s, TextAlign align, Color c) {
+ static const char*anchor[]={"start","middle","end"};
+ flushPath();
+ put("<text x=\""); put(long(x)); put("\" y=\""); put(long(y+fontAscent));
+ put("\" text-anchor=\""); put(anchor[align]); put("\" fill=\"");
+ colour(c);
+ put("\">");
+ for (; *s; s++) switch (*s) {
+  case '<': put("&lt;"); break;
+  case '>': put("&gt;"); break;
+  case '&': put("&amp;"); break;
+  default: put(s,1);
+ }
+ put("</text>\n");
+}
+
+void PlotSvg::clip(int l, int t, int r, int b) {
+ unclip();
+ put("<clipPath id=\"c"); put(long(++clips)); put("\"><rect x=\""); put(l-0.5);
+ put("\" y=\""); put(t-0.5); put("\" width=\""); put(long(r-l));
+ put("\" height=\""); put(long(b-t)); put("\"/></clipPath>\n");
+ put("<g clip-path=\"url(#c"); put(long(clips)); put(")\">\n");
+ clipped=true;
+}
+
+void PlotSvg::unclip() {
+ flushPath();
+ if (clipped) put("</g>\n");
+ clipped=false;
+}
+
+void PlotSvg::finish() {
+ unclip();
+ put("</g>\n</svg>\n");
+}
+
+/* -------------------------------------------------------- */
+// PlotPdf
+/* Objects: 1 catalog, 2 page tree, 3 page, 4 content stream,
+ * 5 font, 6 length of the content stream, written after it
+ * as it is not known before.
+ */
+
+PlotPdf::PlotPdf(const char*path, int width, int height)
+:PlotVector(path,width,height),clipped(false) {
+ put("%PDF-1.4\n%\xE2\xE3\xCF\xD3\n");
+ obj[1]=written();
+ put("1 0 obj\n<</Type/Catalog/Pages 2 0 R>>\nendobj\n");
+ obj[2]=written();
+ put("2 0 obj\n<</Type/Pages/Kids[3 0 R]/Count 1>>\nendobj\n");
+ obj[3]=written();
+ put("3 0 obj\n<</Type/Page/Parent 2 0 R/MediaBox[0 0 ");
+ put(long(w)); put(" "); put(long(h));
+ put("]/Resources<</Font<</F1 5 0 R>>>>/Contents 4 0 R>>\nendobj\n");
+ obj[5]=written();
+ put("5 0 obj\n<</Type/Font/Subtype/Type1/BaseFont/Helvetica/Encoding/WinAnsiEncoding>>\nendobj\n");
+ obj[4]=written();
+ put("4 0 obj\n<</Length 6 0 R>>\nstream\n");
+ streamStart=written();
+	// y downwards from the top, as the canvas
+ put("1 0 0 -1 .5 "); put(h-0.5); put(" cm 1 j\n");
+}
+
+void PlotPdf::colour(Color c, const char*op) {
+ put(GetRValue(c)/255.); put(" ");
+ put(GetGValue(c)/255.); put(" ");
+ put(GetBValue(c)/255.); put(" ");
+ put(op);
+}
+
+void PlotPdf::stroke() {
+ colour(ink,"RG ");
+ put(long(penWidth));
+ put(penStyle==DOT ? " w [1 1] 0 d\n" : " w [] 0 d\n");
+}
+
+void PlotPdf::beginPath() {stroke();}
+
+void PlotPdf::pathPoint(Point p, bool start) {
+ put(long(p.x));
+ put(" ");
+ put(long(p.y));
+ put(start ? " m\n" : " l\n");
+}
+
+void PlotPdf::endPath() {put("S\n");}
+
+void PlotPdf::erase(Color c) {
+ flushPath();
+ colour(c,"rg -1 -1 ");
+ put(long(w+2)); put(" "); put(long(h+2)); put(" re f\n");
+}
+
+void PlotPdf::rectangle(int l, int t, int r, int b, Color fill) {
+ flushPath();
+ stroke();
+ colour(fill,"rg ");
+ put(long(l)); put(" "); put(long(t)); put(" ");
+ put(long(r-1-l)); put(" "); put(long(b-1-t)); put(" re B\n");
+}
+
+void PlotPdf::text(int x, int y, const char*s, TextAlign align, Color c) {
+ flushPath();
+ if (align==CENTER) x-=textWidth(s)/2;
+ else if (align==RIGHT) x-=textWidth(s);
+ put("BT /F1 "); put(long(fontSize)); put(" Tf ");
+ colour(c,"rg 1 0 0 -1 ");
+ put(long(x)); put(" "); put(long(y+fontAscent)); put(" Tm (");
+ for (; *s; s++) {
+  if (*s=='(' || *s==')' || *s=='\\') put("\\",1);
+  put(s,1);
+ }
+ put(") Tj ET\n");
+}
+
+void PlotPdf::clip(int l, int t, int r, int b) {
+ unclip();
+ put("q "); put(l-0.5); put(" "); put(t-0.5); put(" ");
+ put(long(r-l)); put(" "); put(long(b-t)); put(" re W n\n");
+ clipped=true;
+}
+
+void PlotPdf::unclip() {
+ flushPath();
+ if (clipped) put("Q\n");
+ clipped=false;
+}
+
+void PlotPdf::finish() {
+ unclip();
+ size_t length=written()-streamStart;
+ put("\nendstream\nendobj\n");
+ obj[6]=written();
+ put("6 0 obj\n"); put(long(length)); put("\nendobj\n");
+ size_t xref=written();
+ put("xref\n0 7\n0000000000 65535 f \n");
+ for (int i=1; i<7; i++) {
+  char s[21];
+  snprintf(s,sizeof s,"%010lu 00000 n \n",(unsigned long)obj[i]);
+  put(s,20);
+ }
+ put("trailer\n<</Size 7/Root 1 0 R>>\nstartxref\n");
+ put(long(xref));
+ put("\n%%EOF\n");
+}
@@ -1,5 +1,10 @@
 #include "Plotstream.h"
 #include <math.h>
+#include <stdlib.h>
+
+#ifdef _WIN32	// the plot window; elsewhere, see PlotRaster.h
+
+#include <windowsx.h>
 
 //bool std::isfinite(double v) {return !!_finite(v);}
 //double std::round(double v) {return ::floor(v+0.5);}
@@ -9,6 +14,23 @@
 // return fmod(a,b);
 //}
 
+/* Mouse: the wheel zooms about the cursor, a left drag pans, a right
+ * drag zooms onto the box drawn; a left click goes on as before, a right
+ * click or Home shows the whole data again.
+ */
+static const int dragPixels=4;	// moves less than this are clicks
+static POINT down, last;	// where the button went down, last position
+static bool moved;		// a drag, not a click
+static RECT band;		// box shown while right dragging
+static bool banded;
+
+static void showBand(HWND wnd) {	// XOR: shows and hides
+ HDC dc=GetDC(wnd);
+ DrawFocusRect(dc,&band);
+ ReleaseDC(wnd,dc);
+ banded=!banded;
+}
+
 LRESULT CALLBACK PlotWindowProc(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam) {
  Plotstream*ps=(Plotstream*)GetWindowLongPtr(wnd,0);
  switch (msg) {
@@ -25,6 +47,7 @@ LRESULT CALLBACK PlotWindowProc(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam
    ps->onPaint();
    EndPaint(wnd,&s);
   }return 0;
+  case WM_ERASEBKGND: return 1;	// onPaint() covers it all
   case WM_PRINTCLIENT: {
    ps->dc=(HDC)wParam;
    ps->onPaint();
@@ -32,8 +55,49 @@ LRESULT CALLBACK PlotWindowProc(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam
   case WM_KEYDOWN: switch (wParam) {
    case VK_ESCAPE: DestroyWindow(wnd); break;
    case VK_SPACE: PostQuitMessage(2); break;
+   case VK_HOME: ps->unzoom(); InvalidateRect(wnd,0,FALSE); break;
   }break;
-  case WM_LBUTTONDOWN: PostQuitMessage(1); break;
+  case WM_MOUSEWHEEL: {
+   POINT p={GET_X_LPARAM(lParam),GET_Y_LPARAM(lParam)};	// on the screen
+   ScreenToClient(wnd,&p);
+   ps->zoom(float_t(pow(1.25,GET_WHEEL_DELTA_WPARAM(wParam)/double(WHEEL_DELTA))),p.x,p.y);
+   InvalidateRect(wnd,0,FALSE);
+  }return 0;
+  case WM_LBUTTONDOWN:
+  case WM_RBUTTONDOWN:
+   SetCapture(wnd);
+   down.x=last.x=GET_X_LPARAM(lParam);
+   down.y=last.y=GET_Y_LPARAM(lParam);
+   moved=false;
+   return 0;
+  case WM_MOUSEMOVE: if (GetCapture()==wnd) {
+   POINT p={GET_X_LPARAM(lParam),GET_Y_LPARAM(lParam)};
+   if (abs(p.x-down.x)+abs(p.y-down.y)>=dragPixels) moved=true;
+   if (!moved) return 0;
+   if (wParam&MK_LBUTTON) {
+    ps->pan(p.x-last.x,p.y-last.y);
+    InvalidateRect(wnd,0,FALSE);
+    UpdateWindow(wnd);
+   }else if (wParam&MK_RBUTTON) {
+    if (banded) showBand(wnd);
+    SetRect(&band,min(down.x,p.x),min(down.y,p.y),max(down.x,p.x),max(down.y,p.y));
+    showBand(wnd);
+   }
+   last=p;
+  }return 0;
+  case WM_LBUTTONUP:
+   if (GetCapture()!=wnd) break;
+   ReleaseCapture();
+   if (!moved) PostQuitMessage(1);	// a click
+   return 0;
+  case WM_RBUTTONUP:
+   if (GetCapture()!=wnd) break;
+   ReleaseCapture();
+   if (banded) showBand(wnd);
+   if (moved) ps->zoomBox(down.x,down.y,GET_X_LPARAM(lParam),GET_Y_LPARAM(lParam));
+   else ps->unzoom();
+   InvalidateRect(wnd,0,FALSE);
+   return 0;
   case WM_CLOSE: DestroyWindow(wnd); break;
   case WM_DESTROY: PostQuitMessage(0); break;
   case WM_NCDESTROY: ps->wnd=0; break;
@@ -57,3 +121,5 @@ initializer::initializer() {
  wc.lpszClassName="koolplot";
  RegisterClass(&wc);
 }
+
+#endif